@@ -3,23 +3,20 @@
 #include <map>
 #include <set>
 #include <string>
+#include <algorithm>
+#include "GrammarFile.h"
+#include "GrammarStats.h"
+#include "LRTable.h"
 
 using namespace std;
 
-// Production rule structure
-struct Production {
-    char lhs;
-    string rhs;
-    Production(char l, string r) : lhs(l), rhs(r) {}
-};
-
-// LR(1) Item structure - includes lookahead
+// LR(1) Item structure - includes lookahead (a terminal id)
 struct Item {
     int prodIndex;
     int dotPos;
-    char lookahead;
+    int lookahead;
     
-    Item(int p, int d, char l) : prodIndex(p), dotPos(d), lookahead(l) {}
+    Item(int p, int d, int l) : prodIndex(p), dotPos(d), lookahead(l) {}
     
     bool operator<(const Item& other) const {
         if (prodIndex != other.prodIndex) return prodIndex < other.prodIndex;
@@ -34,218 +31,182 @@ struct Item {
 
 class CLRTableBuilder {
 private:
-    vector<Production> prods;
-    map<pair<int, char>, string> actionTable;
-    map<pair<int, char>, int> gotoTable;
-    
-    // Helper function to check if character is non-terminal
-    bool isNonTerminal(char c) {
-        return c >= 'A' && c <= 'Z';
-    }
+    Grammar g;
+    SuffixFirst suffix;     // FIRST of every production suffix
+    map<pair<int, int>, string> actionTable;
+    map<pair<int, int>, int> gotoTable;
+    vector<string> conflicts;       // ACTION cells claimed twice (see setAction)
+    PhaseStats *stats = nullptr;    // --stats: time the phases instead of printing
+    int numStates = 0;
     
-    // Helper function to check if character is terminal
-    bool isTerminal(char c) {
-        return !isNonTerminal(c) && c != '$';
+    // Symbol after the dot, or -1 if the dot is at the end
+    int nextSymbol(const Item& item) {
+        if (item.dotPos >= g.rhsLength(item.prodIndex)) return -1;
+        return g.rhs(item.prodIndex)[item.dotPos];
     }
     
-    // Compute FIRST set for a string
-    set<char> first(const string& str) {
-        set<char> result;
-        
-        if (str.empty()) {
-            result.insert('#'); // epsilon
-            return result;
-        }
+    // Lookaheads of items [B -> .gamma] added for [A -> alpha . B beta, a]:
+    // FIRST(beta a) is the precomputed FIRST(beta), plus a if beta is nullable
+    vector<int> lookaheadsAfter(const Item& item) {
+        const uint64_t *firstOfBeta = suffix.row(item.prodIndex, item.dotPos + 1);
         
-        char firstChar = str[0];
-        
-        if (isTerminal(firstChar)) {
-            result.insert(firstChar);
-        } else if (isNonTerminal(firstChar)) {
-            // Simplified: for our grammar, we know FIRST sets
-            if (firstChar == 'S' || firstChar == 'A' || firstChar == 'B') {
-                result.insert('a');
+        vector<int> lookaheads;
+        for (int w = 0; w < suffix.sets.words; w++) {
+            for (uint64_t bits = firstOfBeta[w]; bits; bits &= bits - 1) {
+                int t = w * 64 + __builtin_ctzll(bits);
+                if (t != g.epsilon) lookaheads.push_back(t);
             }
         }
-        
-        return result;
+        if (suffix.nullable(item.prodIndex, item.dotPos + 1)) lookaheads.push_back(item.lookahead);
+        return lookaheads;
     }
     
     // Get closure of LR(1) items
     set<Item> getClosure(const set<Item>& items) {
         set<Item> closure = items;
-        bool changed = true;
+        vector<Item> work(items.begin(), items.end());
         
-        while (changed) {
-            changed = false;
-            set<Item> newItems;
+        while (!work.empty()) {
+            Item item = work.back();
+            work.pop_back();
             
-            for (const auto& item : closure) {
-                const Production& prod = prods[item.prodIndex];
-                
-                // If dot is at the end, skip
-                if (item.dotPos >= prod.rhs.length()) continue;
-                
-                char nextSym = prod.rhs[item.dotPos];
+            int nextSym = nextSymbol(item);
+            
+            // If next symbol is non-terminal
+            if (nextSym >= 0 && !g.isTerminal(nextSym)) {
+                vector<int> lookaheads = lookaheadsAfter(item);
                 
-                // If next symbol is non-terminal
-                if (isNonTerminal(nextSym)) {
-                    // Compute the beta string (remaining after nextSym)
-                    string beta = prod.rhs.substr(item.dotPos + 1);
-                    
-                    // Compute FIRST(beta + lookahead)
-                    set<char> lookaheads;
-                    if (beta.empty()) {
-                        lookaheads.insert(item.lookahead);
-                    } else {
-                        beta.push_back(item.lookahead);
-                        lookaheads = first(beta);
-                    }
-                    
-                    // Add all productions of this non-terminal with each lookahead
-                    for (int i = 0; i < prods.size(); i++) {
-                        if (prods[i].lhs == nextSym) {
-                            for (char la : lookaheads) {
-                                Item newItem(i, 0, la);
-                                if (closure.find(newItem) == closure.end()) {
-                                    newItems.insert(newItem);
-                                    changed = true;
-                                }
-                            }
+                // Add all productions of this non-terminal with each lookahead
+                int r = g.row(nextSym);
+                for (int k = g.lhsStart[r]; k < g.lhsStart[r + 1]; k++) {
+                    for (int la : lookaheads) {
+                        Item newItem(g.byLhs[k], 0, la);
+                        if (closure.insert(newItem).second) {
+                            work.push_back(newItem);
                         }
                     }
                 }
             }
-            
-            for (const auto& item : newItems) {
-                closure.insert(item);
-            }
         }
         
         return closure;
     }
     
     // Get goto set for LR(1) items
-    set<Item> getGoto(const set<Item>& items, char symbol) {
+    set<Item> getGoto(const set<Item>& items, int symbol) {
         set<Item> gotoSet;
         
         for (const auto& item : items) {
-            const Production& prod = prods[item.prodIndex];
-            
-            if (item.dotPos < prod.rhs.length() && prod.rhs[item.dotPos] == symbol) {
+            if (nextSymbol(item) == symbol) {
                 gotoSet.insert(Item{item.prodIndex, item.dotPos + 1, item.lookahead});
             }
         }
         
         return getClosure(gotoSet);
     }
-    
-    // Check if two sets of items are equal
-    bool areItemsEqual(const set<Item>& a, const set<Item>& b) {
-        if (a.size() != b.size()) return false;
-        
-        auto it1 = a.begin();
-        auto it2 = b.begin();
-        
-        while (it1 != a.end() && it2 != b.end()) {
-            if (!(*it1 == *it2)) return false;
-            ++it1;
-            ++it2;
-        }
-        
-        return true;
-    }
-    
+
 public:
     CLRTableBuilder() {
         // Simple grammar: S -> A + B, A -> a, B -> b
         
-        prods.push_back(Production('X', "S"));   // Augmented production (0)
-        prods.push_back(Production('S', "A+B")); // Production 1
-        prods.push_back(Production('A', "a"));   // Production 2
-        prods.push_back(Production('B', "b"));   // Production 3
+        GrammarBuilder grammar;
+        grammar.addProduction("S'", {"S"});  // Augmented production (0)
+        grammar.addLine("S->A+B");           // Production 1
+        grammar.addLine("A->a");             // Production 2
+        grammar.addLine("B->b");             // Production 3
+        g = grammar.build("S'");
+        suffix = computeSuffixFirst(g, computeFirst(g));
+    }
+    
+    // augmented grammar: production 0 is S' -> S
+    CLRTableBuilder(const Grammar &augmented, PhaseStats *phases = nullptr) : g(augmented), stats(phases) {
+        if (stats) stats->start();
+        suffix = computeSuffixFirst(g, computeFirst(g));
+        if (stats) stats->stop("first");
     }
     
     void buildTable() {
         // Step 1: Build canonical collection of LR(1) items
         vector<set<Item>> states;
-        map<pair<int, char>, int> transitions;
+        map<set<Item>, int> stateIndex;
+        map<pair<int, int>, int> transitions;
         
-        // Initial state: closure of {[X -> .S, $]}
+        // Initial state: closure of {[S' -> .S, $]}
         set<Item> initial;
-        initial.insert(Item{0, 0, '$'});
+        initial.insert(Item{0, 0, g.endMarker});
         states.push_back(getClosure(initial));
+        stateIndex[states[0]] = 0;
         
         // Build states
         for (int i = 0; i < states.size(); i++) {
             set<Item> currentState = states[i];
             
             // Get all symbols that appear after dots
-            set<char> symbols;
+            set<int> symbols;
             for (const auto& item : currentState) {
-                const Production& prod = prods[item.prodIndex];
-                if (item.dotPos < prod.rhs.length()) {
-                    symbols.insert(prod.rhs[item.dotPos]);
+                if (nextSymbol(item) >= 0) {
+                    symbols.insert(nextSymbol(item));
                 }
             }
             
             // For each symbol, compute goto
-            for (char sym : symbols) {
+            // in name order, so states are numbered as in the original char-based tables
+            vector<int> order(symbols.begin(), symbols.end());
+            sort(order.begin(), order.end(), [&](int a, int b) { return g.names[a] < g.names[b]; });
+            for (int sym : order) {
                 set<Item> gotoSet = getGoto(currentState, sym);
                 
                 if (!gotoSet.empty()) {
-                    // Check if this state already exists
-                    int stateIndex = -1;
-                    for (int j = 0; j < states.size(); j++) {
-                        if (areItemsEqual(states[j], gotoSet)) {
-                            stateIndex = j;
-                            break;
-                        }
-                    }
-                    
-                    if (stateIndex == -1) {
-                        stateIndex = states.size();
+                    // Reuse the state if it already exists
+                    auto found = stateIndex.find(gotoSet);
+                    int target;
+                    if (found == stateIndex.end()) {
+                        target = states.size();
+                        stateIndex[gotoSet] = target;
                         states.push_back(gotoSet);
+                    } else {
+                        target = found->second;
                     }
                     
-                    transitions[{i, sym}] = stateIndex;
+                    transitions[{i, sym}] = target;
                 }
             }
         }
+        if (stats) stats->stop("clr_automaton");
         
         // Step 2: Build ACTION and GOTO tables
+        numStates = states.size();
         for (int i = 0; i < states.size(); i++) {
             set<Item> currentState = states[i];
             
             // Check each item in the state
             for (const auto& item : currentState) {
-                const Production& prod = prods[item.prodIndex];
+                int nextSym = nextSymbol(item);
                 
                 // Case 1: Shift
-                if (item.dotPos < prod.rhs.length()) {
-                    char nextSym = prod.rhs[item.dotPos];
-                    if (isTerminal(nextSym)) {
+                if (nextSym >= 0) {
+                    if (g.isTerminal(nextSym)) {
                         auto it = transitions.find({i, nextSym});
                         if (it != transitions.end()) {
-                            actionTable[{i, nextSym}] = "s" + to_string(it->second);
+                            setAction(g, actionTable, conflicts, i, nextSym, "s" + to_string(it->second));
                         }
                     }
                 }
                 // Case 2: Reduce/Accept
                 else {
-                    if (item.prodIndex == 0 && item.lookahead == '$') {
-                        // X -> S., $ (Accept)
-                        actionTable[{i, '$'}] = "acc";
+                    if (item.prodIndex == 0 && item.lookahead == g.endMarker) {
+                        // S' -> S., $ (Accept)
+                        setAction(g, actionTable, conflicts, i, g.endMarker, "acc");
                     } else {
                         // Regular reduce: use the item's lookahead
-                        actionTable[{i, item.lookahead}] = "r" + to_string(item.prodIndex);
+                        setAction(g, actionTable, conflicts, i, item.lookahead, "r" + to_string(item.prodIndex));
                     }
                 }
             }
             
             // Build GOTO table for non-terminals
-            for (char nt = 'A'; nt <= 'Z'; nt++) {
-                if (nt == 'X') continue;  // Skip augmented start
+            for (int nt = g.numTerminals; nt < g.numSymbols(); nt++) {
+                if (nt == g.start) continue;  // Skip augmented start
                 
                 auto it = transitions.find({i, nt});
                 if (it != transitions.end()) {
@@ -254,37 +215,55 @@ public:
             }
         }
         
+        if (stats) {
+            stats->stop("clr_table");
+            countAutomaton(states, transitions.size());
+            return;
+        }
+        
         // Display results
         displayTables(states);
     }
     
+    // The tables as integer arrays, after buildTable()
+    LRTables compiled() const { return compileLR(g, numStates, actionTable, gotoTable); }
+    const vector<string>& actionConflicts() const { return conflicts; }
+    
+    void countAutomaton(const vector<set<Item>>& states, size_t transitions) {
+        size_t items = 0;
+        for (const auto& state : states) items += state.size();
+        stats->count("states", states.size());
+        stats->count("items", items);
+        stats->count("transitions", transitions);
+        stats->count("actions", actionTable.size());
+        stats->count("conflicts", conflicts.size());
+    }
+    
     void displayTables(const vector<set<Item>>& states) {
         // cout << "CLR (CANONICAL LR) PARSING TABLE\n";
         // cout << "================================\n\n";
         
         cout << "Grammar:\n";
-        cout << "0: X -> S     (augmented start)\n";
-        cout << "1: S -> A + B\n";
-        cout << "2: A -> a\n";
-        cout << "3: B -> b\n\n";
-        
-        // Create list of terminals and non-terminals
-        set<char> terminals = {'a', 'b', '+', '$'};
-        set<char> nonTerminals = {'S', 'A', 'B'};
+        for (int p = 0; p < g.numProductions(); p++) {
+            cout << p << ": " << productionString(g, p);
+            if (p == 0) cout << "     (augmented start)";
+            cout << "\n";
+        }
+        cout << "\n";
         
         // Display combined ACTION and GOTO table
         cout << "CLR Parsing Table:\n";
         cout << "State\t";
         
         // Display ACTION columns (terminals)
-        for (char t : terminals) {
-            cout << t << "\t";
+        for (int t = 0; t < g.numTerminals; t++) {
+            if (t != g.epsilon) cout << g.names[t] << "\t";
         }
         
         // Display GOTO columns (non-terminals)
-        for (char nt : nonTerminals) {
-            if (nt != 'X') {
-                cout << nt << "\t";
+        for (int nt = g.numTerminals; nt < g.numSymbols(); nt++) {
+            if (nt != g.start) {  // Skip augmented start
+                cout << g.names[nt] << "\t";
             }
         }
         cout << endl;
@@ -294,7 +273,8 @@ public:
             cout << i << "\t";
             
             // Display ACTION table entries
-            for (char t : terminals) {
+            for (int t = 0; t < g.numTerminals; t++) {
+                if (t == g.epsilon) continue;
                 auto it = actionTable.find({i, t});
                 if (it != actionTable.end()) {
                     cout << it->second;
@@ -303,8 +283,8 @@ public:
             }
             
             // Display GOTO table entries
-            for (char nt : nonTerminals) {
-                if (nt != 'X') {
+            for (int nt = g.numTerminals; nt < g.numSymbols(); nt++) {
+                if (nt != g.start) {  // Skip augmented start
                     auto it = gotoTable.find({i, nt});
                     if (it != gotoTable.end()) {
                         cout << it->second;
@@ -314,6 +294,10 @@ public:
             }
             cout << endl;
         }
+        if (!conflicts.empty()) {
+            cout << "\nWARNING: ";
+            printLRConflicts(cout, "LR(1)", conflicts);
+        }
         
         // Display legend
         // cout << "\nLEGEND:\n";
@@ -328,27 +312,53 @@ public:
         for (int i = 0; i < states.size(); i++) {
             cout << "\nState " << i << ":\n";
             for (const auto& item : states[i]) {
-                const Production& prod = prods[item.prodIndex];
-                cout << "  [" << prod.lhs << " -> ";
-                for (int j = 0; j < prod.rhs.length(); j++) {
-                    if (j == item.dotPos) cout << ".";
-                    cout << prod.rhs[j];
-                }
-                if (item.dotPos == prod.rhs.length()) cout << ".";
-                cout << ", " << item.lookahead << "]";
+                cout << "  [" << itemString(g, item.prodIndex, item.dotPos) << ", " << g.names[item.lookahead] << "]";
             }
         }
-        
-        // Display productions
-        // cout << "\nProductions:\n";
-        // for (int i = 0; i < prods.size(); i++) {
-        //     cout << i << ": " << prods[i].lhs << " -> " << prods[i].rhs << endl;
-        // }
     }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
+    // --grammar file builds the table for a grammar file instead of the example (see GrammarFile.h)
+    // --stats prints phase timings instead of the table (see GrammarStats.h)
+    // --compress reports comb-vector table sizes instead, and with --bench N the parse
+    //   rates on a generated sentence of about N tokens (see LRTable.h); both need a
+    //   table without conflicts
+    const char *grammarFile = nullptr;
+    bool stats = false;
+    bool compress = false;
+    size_t benchTokens = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--grammar" && i + 1 < argc) grammarFile = argv[++i];
+        else if (arg == "--stats") stats = true;
+        else if (arg == "--compress") compress = true;
+        else if (arg == "--bench" && i + 1 < argc) benchTokens = atoll(argv[++i]);
+    }
+    
+    if (grammarFile) {
+        Grammar g;
+        string error;
+        if (!loadGrammarFile(grammarFile, g, error, true)) {
+            cerr << error << "\n";
+            return 1;
+        }
+        PhaseStats phases;
+        if (stats) countGrammar(phases, g);
+        // compressing builds the table through the quiet --stats path
+        CLRTableBuilder parser(g, stats || compress ? &phases : nullptr);
+        parser.buildTable();
+        if (compress && !parser.actionConflicts().empty()) {
+            printLRConflicts(cerr, "LR(1)", parser.actionConflicts());
+            cerr << "--compress and --bench need a conflict-free table\n";
+            return 1;
+        }
+        if (compress && !reportLRCompression(g, parser.compiled(), benchTokens, stats ? &phases : nullptr)) return 1;
+        if (stats) phases.print();
+        return 0;
+    }
+
     CLRTableBuilder parser;
     parser.buildTable();
     return 0;
-}
\ No newline at end of file
+}
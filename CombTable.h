@@ -0,0 +1,112 @@
+#pragma once
+
+#include <bits/stdc++.h>
+using namespace std;
+
+// Row-displacement ("comb vector") compression of a sparse 2-D table,
+// used for the LL(1) table and the LR ACTION/GOTO tables (--compress).
+//
+// Every row is overlaid on one shared value array at its own
+// displacement base[row], chosen first-fit so that its entries land on
+// free slots. check[i] records which row owns slot i, so a lookup is
+// one add and one compare. With default elision a row's most frequent
+// entry is not stored at all: it becomes defaults[row], returned for
+// every slot the row does not own, error slots included. That is only
+// sound for entries that consume no input, as with yacc's default
+// reductions. An LR reduction or an LL prediction taken in place of an
+// error still leaves the bad token to be rejected before it is consumed.
+// A shift would consume it and accept input the dense table rejects, so
+// callers pass mayDefault to keep shifts (and accept) explicit.
+template <class T>
+class CombTable {
+public:
+    int rows = 0, cols = 0;
+    vector<int32_t> base;       // per row
+    vector<T> values;
+    vector<int32_t> check;      // owning row of each slot, -1 if free
+    vector<T> defaults;         // per row: entry for slots the row does not own
+
+    T at(int row, int col) const {
+        size_t i = (size_t)base[row] + col;
+        return check[i] == row ? values[i] : defaults[row];
+    }
+
+    size_t bytes() const {
+        return base.size() * sizeof(int32_t) + values.size() * sizeof(T) + check.size() * sizeof(int32_t) +
+               defaults.size() * sizeof(T);
+    }
+};
+
+// Compresses the rows x cols array dense, whose error entry is empty.
+// With elideDefaults each row's most frequent non-empty entry that
+// mayDefault allows (any, if null) becomes its default; otherwise every
+// default is empty and lookups match dense exactly.
+template <class T>
+CombTable<T> compressTable(const T *dense, int rows, int cols, T empty, bool elideDefaults,
+                           bool (*mayDefault)(T) = nullptr) {
+    CombTable<T> comb;
+    comb.rows = rows;
+    comb.cols = cols;
+    comb.base.assign(rows, 0);
+    comb.defaults.assign(rows, empty);
+
+    // the columns each row still has to store
+    vector<vector<int>> entries(rows);
+    for (int r = 0; r < rows; r++) {
+        const T *row = dense + (size_t)r * cols;
+        if (elideDefaults) {
+            map<T, int> frequency;
+            for (int c = 0; c < cols; c++) {
+                if (row[c] != empty && (!mayDefault || mayDefault(row[c]))) frequency[row[c]]++;
+            }
+            int most = 0;
+            for (auto &f : frequency) {
+                if (f.second > most) {
+                    most = f.second;
+                    comb.defaults[r] = f.first;
+                }
+            }
+        }
+        for (int c = 0; c < cols; c++) {
+            if (row[c] != comb.defaults[r] && row[c] != empty) entries[r].push_back(c);
+        }
+    }
+
+    // densest rows first, each at the lowest displacement where it fits
+    vector<int> order(rows);
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return entries[a].size() > entries[b].size(); });
+    size_t firstFree = 0;
+    for (int r : order) {
+        const vector<int> &cs = entries[r];
+        if (cs.empty()) continue;       // every lookup falls through to the default
+        size_t d = firstFree > (size_t)cs[0] ? firstFree - cs[0] : 0;
+        for (;; d++) {
+            bool fits = true;
+            for (int c : cs) {
+                if (d + c < comb.check.size() && comb.check[d + c] >= 0) {
+                    fits = false;
+                    break;
+                }
+            }
+            if (fits) break;
+        }
+        if (comb.check.size() < d + cs.back() + 1) {
+            comb.check.resize(d + cs.back() + 1, -1);
+            comb.values.resize(d + cs.back() + 1, empty);
+        }
+        comb.base[r] = d;
+        for (int c : cs) {
+            comb.check[d + c] = r;
+            comb.values[d + c] = dense[(size_t)r * cols + c];
+        }
+        while (firstFree < comb.check.size() && comb.check[firstFree] >= 0) firstFree++;
+    }
+
+    // every row may probe up to base + cols - 1
+    size_t reach = 0;
+    for (int r = 0; r < rows; r++) reach = max(reach, (size_t)comb.base[r] + cols);
+    comb.check.resize(max(reach, comb.check.size()), -1);
+    comb.values.resize(comb.check.size(), empty);
+    return comb;
+}
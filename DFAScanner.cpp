@@ -0,0 +1,756 @@
+#include <bits/stdc++.h>
+using namespace std;
+
+// Table-driven scanner generated from the flex spec in Lexer.txt
+// regex -> Thompson NFA -> subset construction DFA -> Hopcroft minimization
+
+// ---------------- Token spec ----------------
+
+struct Rule {
+    string name;    // token name printed by the scanner
+    string regex;   // pattern with {NAME} references expanded
+    bool skip;      // action is ';' (whitespace etc.)
+};
+
+string trim(const string &s) {
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == string::npos) return "";
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+// Length of the pattern at the start of a rule line (spaces inside [...] or "..." do not end it)
+size_t patternLength(const string &line) {
+    size_t i = 0;
+    bool inClass = false, inQuote = false;
+    while (i < line.size()) {
+        char c = line[i];
+        if (c == '\\') { i += 2; continue; }
+        if (inClass) { if (c == ']') inClass = false; }
+        else if (inQuote) { if (c == '"') inQuote = false; }
+        else if (c == '[') inClass = true;
+        else if (c == '"') inQuote = true;
+        else if (c == ' ' || c == '\t') break;
+        i++;
+    }
+    return min(i, line.size());
+}
+
+string expandDefinitions(const string &pattern, const map<string, string> &defs) {
+    string out;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        if (pattern[i] == '\\' && i + 1 < pattern.size()) {
+            out += pattern[i];
+            out += pattern[++i];
+        } else if (pattern[i] == '{') {
+            size_t end = pattern.find('}', i);
+            string name = pattern.substr(i + 1, end - i - 1);
+            auto it = defs.find(name);
+            if (end == string::npos || it == defs.end()) {
+                out += pattern[i];
+                continue;
+            }
+            out += "(" + it->second + ")";
+            i = end;
+        } else {
+            out += pattern[i];
+        }
+    }
+    return out;
+}
+
+// Reads the definitions and rules sections of a flex file
+vector<Rule> readSpec(const string &path) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "Cannot open spec file " << path << endl;
+        exit(1);
+    }
+
+    map<string, string> defs;
+    vector<Rule> rules;
+    string line;
+    int section = 0;    // 0 = before %}, 1 = definitions, 2 = rules
+    bool seenCode = false;
+
+    while (getline(in, line)) {
+        string t = trim(line);
+        if (t == "%{") { seenCode = true; continue; }
+        if (t == "%}") { section = 1; continue; }
+        if (t == "%%") {
+            if (section == 2) break;
+            section = 2;
+            continue;
+        }
+        if (!seenCode || section == 0 || t.empty() || t.rfind("/*", 0) == 0) continue;
+
+        if (section == 1) {
+            size_t sp = t.find_first_of(" \t");
+            if (sp == string::npos) continue;
+            defs[t.substr(0, sp)] = trim(t.substr(sp));
+        } else {
+            size_t len = patternLength(t);
+            string pattern = t.substr(0, len);
+            string action = trim(t.substr(len));
+            // The catch-all '.' rule is handled by the scanner itself
+            if (pattern == ".") continue;
+
+            Rule r;
+            r.regex = expandDefinitions(pattern, defs);
+            r.skip = action.empty() || action[0] == ';';
+            size_t q = action.find("printf(\"");
+            if (q != string::npos) {
+                size_t colon = action.find(':', q);
+                r.name = action.substr(q + 8, colon - q - 8);
+            } else if (pattern.size() > 2 && pattern[0] == '{') {
+                r.name = pattern.substr(1, pattern.size() - 2);
+            } else {
+                r.name = r.skip ? "SKIP" : pattern;
+            }
+            rules.push_back(r);
+        }
+    }
+    return rules;
+}
+
+// ---------------- Thompson NFA ----------------
+
+struct NFAState {
+    vector<int> eps;
+    bitset<256> chars;  // labels of the single non-epsilon edge
+    int next = -1;
+    int accept = -1;    // rule index if accepting
+};
+
+vector<NFAState> nfa;
+
+struct Fragment {
+    int start, end;
+};
+
+int newState() {
+    nfa.push_back(NFAState());
+    return nfa.size() - 1;
+}
+
+Fragment charFragment(const bitset<256> &chars) {
+    int s = newState(), e = newState();
+    nfa[s].chars = chars;
+    nfa[s].next = e;
+    return {s, e};
+}
+
+Fragment concatFragment(Fragment a, Fragment b) {
+    nfa[a.end].eps.push_back(b.start);
+    return {a.start, b.end};
+}
+
+Fragment unionFragment(Fragment a, Fragment b) {
+    int s = newState(), e = newState();
+    nfa[s].eps = {a.start, b.start};
+    nfa[a.end].eps.push_back(e);
+    nfa[b.end].eps.push_back(e);
+    return {s, e};
+}
+
+Fragment starFragment(Fragment a) {
+    int s = newState(), e = newState();
+    nfa[s].eps = {a.start, e};
+    nfa[a.end].eps.push_back(a.start);
+    nfa[a.end].eps.push_back(e);
+    return {s, e};
+}
+
+Fragment emptyFragment() {
+    int s = newState(), e = newState();
+    nfa[s].eps.push_back(e);
+    return {s, e};
+}
+
+// Copies a fragment so it can be reused (needed for '+')
+Fragment cloneFragment(Fragment f) {
+    map<int, int> copy;
+    vector<int> stack = {f.start};
+    copy[f.start] = newState();
+    while (!stack.empty()) {
+        int u = stack.back();
+        stack.pop_back();
+        vector<int> targets = nfa[u].eps;
+        if (nfa[u].next != -1) targets.push_back(nfa[u].next);
+        for (int v : targets) {
+            if (!copy.count(v)) {
+                copy[v] = newState();
+                stack.push_back(v);
+            }
+        }
+    }
+    for (auto p : copy) {
+        NFAState st = nfa[p.first];
+        for (int &v : st.eps) v = copy[v];
+        if (st.next != -1) st.next = copy[st.next];
+        nfa[p.second] = st;
+    }
+    return {copy[f.start], copy[f.end]};
+}
+
+// Recursive descent regex parser for the flex subset used in Lexer.txt
+class RegexParser {
+private:
+    string re;
+    size_t pos;
+
+    char escaped(char c) {
+        if (c == 'n') return '\n';
+        if (c == 't') return '\t';
+        if (c == 'r') return '\r';
+        return c;
+    }
+
+    bitset<256> parseClass() {
+        bitset<256> set;
+        bool negate = false;
+        if (pos < re.size() && re[pos] == '^') {
+            negate = true;
+            pos++;
+        }
+        while (pos < re.size() && re[pos] != ']') {
+            char lo = re[pos++];
+            if (lo == '\\') lo = escaped(re[pos++]);
+            char hi = lo;
+            if (pos + 1 < re.size() && re[pos] == '-' && re[pos + 1] != ']') {
+                pos++;
+                hi = re[pos++];
+                if (hi == '\\') hi = escaped(re[pos++]);
+            }
+            for (int c = (unsigned char)lo; c <= (unsigned char)hi; c++) set[c] = true;
+        }
+        pos++;  // ']'
+        if (negate) set.flip();
+        return set;
+    }
+
+    Fragment parseAtom() {
+        char c = re[pos++];
+        bitset<256> set;
+        if (c == '(') {
+            Fragment f = parseAlternation();
+            pos++;  // ')'
+            return f;
+        }
+        if (c == '[') return charFragment(parseClass());
+        if (c == '"') {
+            Fragment f = emptyFragment();
+            while (pos < re.size() && re[pos] != '"') {
+                char ch = re[pos++];
+                if (ch == '\\') ch = escaped(re[pos++]);
+                set.reset();
+                set[(unsigned char)ch] = true;
+                f = concatFragment(f, charFragment(set));
+            }
+            pos++;
+            return f;
+        }
+        if (c == '.') {
+            set.set();
+            set['\n'] = false;
+            return charFragment(set);
+        }
+        if (c == '\\') c = escaped(re[pos++]);
+        set[(unsigned char)c] = true;
+        return charFragment(set);
+    }
+
+    Fragment parseRepeat() {
+        Fragment f = parseAtom();
+        while (pos < re.size() && (re[pos] == '*' || re[pos] == '+' || re[pos] == '?')) {
+            char op = re[pos++];
+            if (op == '*') {
+                f = starFragment(f);
+            } else if (op == '+') {
+                f = concatFragment(f, starFragment(cloneFragment(f)));
+            } else {
+                f = unionFragment(f, emptyFragment());
+            }
+        }
+        return f;
+    }
+
+    Fragment parseConcat() {
+        Fragment f = emptyFragment();
+        while (pos < re.size() && re[pos] != '|' && re[pos] != ')') {
+            f = concatFragment(f, parseRepeat());
+        }
+        return f;
+    }
+
+    Fragment parseAlternation() {
+        Fragment f = parseConcat();
+        while (pos < re.size() && re[pos] == '|') {
+            pos++;
+            f = unionFragment(f, parseConcat());
+        }
+        return f;
+    }
+
+public:
+    RegexParser(string r) : re(r), pos(0) {}
+
+    Fragment parse() {
+        return parseAlternation();
+    }
+};
+
+// Joins every rule into one NFA; returns the start state
+int buildNFA(const vector<Rule> &rules) {
+    nfa.clear();
+    int start = newState();
+    for (int i = 0; i < rules.size(); i++) {
+        Fragment f = RegexParser(rules[i].regex).parse();
+        nfa[f.end].accept = i;
+        nfa[start].eps.push_back(f.start);
+    }
+    return start;
+}
+
+// ---------------- DFA ----------------
+
+// Compact scanner table: state 0 is the dead state
+struct DFA {
+    int numStates = 0;
+    int numClasses = 0;
+    int start = 0;
+    array<uint8_t, 256> byteClass;
+    vector<uint16_t> next;      // numStates * numClasses
+    vector<int16_t> accept;     // rule index or -1
+};
+
+// Bytes that label exactly the same NFA edges are interchangeable
+int computeByteClasses(array<uint8_t, 256> &byteClass, vector<int> &representative) {
+    map<vector<bool>, int> signatures;
+    for (int c = 0; c < 256; c++) {
+        vector<bool> sig;
+        for (auto &st : nfa) {
+            if (st.next != -1) sig.push_back(st.chars[c]);
+        }
+        auto it = signatures.find(sig);
+        if (it == signatures.end()) {
+            it = signatures.insert({sig, (int)signatures.size()}).first;
+            representative.push_back(c);
+        }
+        byteClass[c] = it->second;
+    }
+    return signatures.size();
+}
+
+vector<int> epsilonClosure(vector<int> states) {
+    vector<bool> seen(nfa.size(), false);
+    vector<int> stack = states;
+    for (int s : states) seen[s] = true;
+    while (!stack.empty()) {
+        int u = stack.back();
+        stack.pop_back();
+        for (int v : nfa[u].eps) {
+            if (!seen[v]) {
+                seen[v] = true;
+                states.push_back(v);
+                stack.push_back(v);
+            }
+        }
+    }
+    sort(states.begin(), states.end());
+    return states;
+}
+
+int acceptingRule(const vector<int> &states) {
+    int best = -1;
+    for (int s : states) {
+        if (nfa[s].accept != -1 && (best == -1 || nfa[s].accept < best)) {
+            best = nfa[s].accept;
+        }
+    }
+    return best;
+}
+
+DFA subsetConstruction(int nfaStart) {
+    DFA dfa;
+    vector<int> representative;
+    dfa.numClasses = computeByteClasses(dfa.byteClass, representative);
+
+    map<vector<int>, int> ids;
+    vector<vector<int>> sets;
+    // dead state
+    sets.push_back({});
+    ids[{}] = 0;
+    dfa.accept.push_back(-1);
+    dfa.next.assign(dfa.numClasses, 0);
+
+    vector<int> startSet = epsilonClosure({nfaStart});
+    ids[startSet] = 1;
+    sets.push_back(startSet);
+    dfa.accept.push_back(acceptingRule(startSet));
+    dfa.next.resize(2 * dfa.numClasses, 0);
+    dfa.start = 1;
+
+    for (int i = 1; i < sets.size(); i++) {
+        for (int c = 0; c < dfa.numClasses; c++) {
+            unsigned char ch = representative[c];
+            vector<int> moved;
+            for (int s : sets[i]) {
+                if (nfa[s].next != -1 && nfa[s].chars[ch]) moved.push_back(nfa[s].next);
+            }
+            vector<int> target = epsilonClosure(moved);
+            auto it = ids.find(target);
+            if (it == ids.end()) {
+                it = ids.insert({target, (int)sets.size()}).first;
+                sets.push_back(target);
+                dfa.accept.push_back(acceptingRule(target));
+                dfa.next.resize(sets.size() * dfa.numClasses, 0);
+            }
+            dfa.next[i * dfa.numClasses + c] = it->second;
+        }
+    }
+    dfa.numStates = sets.size();
+    return dfa;
+}
+
+// Hopcroft's partition refinement; states accepting different rules never merge
+DFA minimize(const DFA &dfa) {
+    int n = dfa.numStates, k = dfa.numClasses;
+
+    // inverse transitions: prev[c][t] = states s with next(s, c) = t
+    vector<vector<vector<int>>> prev(k, vector<vector<int>>(n));
+    for (int s = 0; s < n; s++)
+        for (int c = 0; c < k; c++)
+            prev[c][dfa.next[s * k + c]].push_back(s);
+
+    // initial partition by accepted rule (dead state groups with non-accepting)
+    map<int, int> blockOfRule;
+    vector<int> block(n);
+    vector<vector<int>> blocks;
+    for (int s = 0; s < n; s++) {
+        auto it = blockOfRule.find(dfa.accept[s]);
+        if (it == blockOfRule.end()) {
+            it = blockOfRule.insert({dfa.accept[s], (int)blocks.size()}).first;
+            blocks.push_back({});
+        }
+        block[s] = it->second;
+        blocks[it->second].push_back(s);
+    }
+
+    set<pair<int, int>> work;
+    for (int b = 0; b < blocks.size(); b++)
+        for (int c = 0; c < k; c++)
+            work.insert({b, c});
+
+    vector<int> marked(n, 0);
+    int stamp = 0;
+    while (!work.empty()) {
+        auto [splitter, c] = *work.begin();
+        work.erase(work.begin());
+
+        // X = states that move into the splitter on class c
+        stamp++;
+        vector<int> touchedBlocks;
+        for (int t : blocks[splitter]) {
+            for (int s : prev[c][t]) {
+                if (marked[s] != stamp) {
+                    marked[s] = stamp;
+                    touchedBlocks.push_back(block[s]);
+                }
+            }
+        }
+        sort(touchedBlocks.begin(), touchedBlocks.end());
+        touchedBlocks.erase(unique(touchedBlocks.begin(), touchedBlocks.end()), touchedBlocks.end());
+
+        for (int y : touchedBlocks) {
+            vector<int> in, out;
+            for (int s : blocks[y]) {
+                if (marked[s] == stamp) in.push_back(s);
+                else out.push_back(s);
+            }
+            if (out.empty()) continue;
+
+            // keep the larger half in place, the smaller one becomes a new block
+            if (in.size() > out.size()) swap(in, out);
+            int nb = blocks.size();
+            blocks[y] = out;
+            blocks.push_back(in);
+            for (int s : in) block[s] = nb;
+
+            // whether or not (y, d) is still pending, queuing the smaller half is enough
+            for (int d = 0; d < k; d++) work.insert({nb, d});
+        }
+    }
+
+    // renumber so that the dead state stays 0 and the start state follows it
+    vector<int> newId(blocks.size(), -1);
+    int count = 0;
+    newId[block[0]] = count++;
+    if (newId[block[dfa.start]] == -1) newId[block[dfa.start]] = count++;
+    for (int b = 0; b < blocks.size(); b++)
+        if (newId[b] == -1) newId[b] = count++;
+
+    DFA result;
+    result.numStates = count;
+    result.numClasses = k;
+    result.byteClass = dfa.byteClass;
+    result.start = newId[block[dfa.start]];
+    result.next.assign(count * k, 0);
+    result.accept.assign(count, -1);
+    for (int s = 0; s < n; s++) {
+        int b = newId[block[s]];
+        result.accept[b] = dfa.accept[s];
+        for (int c = 0; c < k; c++)
+            result.next[b * k + c] = newId[block[dfa.next[s * k + c]]];
+    }
+    return result;
+}
+
+// ---------------- Scanner ----------------
+
+struct Token {
+    int rule;       // -1 for unknown characters
+    size_t offset;
+    size_t length;
+};
+
+// Maximal munch: one table lookup per byte, remembering the last accepting position
+vector<Token> scan(const DFA &dfa, const vector<Rule> &rules, const string &text) {
+    vector<Token> tokens;
+    const uint16_t *next = dfa.next.data();
+    const int k = dfa.numClasses;
+    size_t i = 0, n = text.size();
+
+    while (i < n) {
+        int state = dfa.start;
+        int lastRule = -1;
+        size_t lastEnd = i;
+        size_t j = i;
+        while (j < n) {
+            state = next[state * k + dfa.byteClass[(unsigned char)text[j]]];
+            if (state == 0) break;
+            j++;
+            if (dfa.accept[state] != -1) {
+                lastRule = dfa.accept[state];
+                lastEnd = j;
+            }
+        }
+
+        if (lastRule == -1) {
+            tokens.push_back({-1, i, 1});
+            i++;
+            continue;
+        }
+        if (!rules[lastRule].skip) tokens.push_back({lastRule, i, lastEnd - i});
+        i = lastEnd;
+    }
+    return tokens;
+}
+
+// ---------------- Lazy DFA ----------------
+
+// Builds DFA states from the NFA only when the scanner reaches them and keeps
+// at most `capacity` of them. A full cache is flushed; if three flushes in a
+// row come with little input scanned in between, the scanner falls back to
+// plain NFA simulation so memory stays bounded. A flush after a long run of
+// cache hits starts the count again, so warm-up flushes do not add up.
+class LazyDFA {
+private:
+    int nfaStart;
+    size_t capacity;
+    int numClasses;
+    array<uint8_t, 256> byteClass;
+    vector<int> representative;
+
+    // state 0 is dead, state 1 is the start state
+    vector<vector<int>> sets;
+    vector<int> accept;
+    vector<int> next;       // -1 = not built yet
+    map<vector<int>, int> ids;
+
+    size_t bytesSinceFlush = 0;
+    int badFlushes = 0;     // consecutive flushes after little input
+
+    int addState(const vector<int> &set) {
+        int id = sets.size();
+        sets.push_back(set);
+        ids[set] = id;
+        accept.push_back(acceptingRule(set));
+        next.resize(sets.size() * numClasses, -1);
+        statesBuilt++;
+        return id;
+    }
+
+    void reset() {
+        sets.clear();
+        accept.clear();
+        next.clear();
+        ids.clear();
+        addState({});
+        addState(epsilonClosure({nfaStart}));
+    }
+
+    vector<int> move(const vector<int> &set, int cls) {
+        unsigned char ch = representative[cls];
+        vector<int> moved;
+        for (int s : set) {
+            if (nfa[s].next != -1 && nfa[s].chars[ch]) moved.push_back(nfa[s].next);
+        }
+        return epsilonClosure(moved);
+    }
+
+    // Slow path of step(): compute and cache the transition
+    int build(int state, int cls) {
+        vector<int> target = move(sets[state], cls);
+        auto it = ids.find(target);
+        if (it != ids.end()) {
+            next[state * numClasses + cls] = it->second;
+            return it->second;
+        }
+        if (sets.size() >= capacity) {
+            // flushing drops every state id, only the target is carried over
+            flushes++;
+            if (bytesSinceFlush >= 10 * capacity) badFlushes = 0;
+            else if (++badFlushes >= 3) fallback = true;
+            bytesSinceFlush = 0;
+            reset();
+            auto again = ids.find(target);
+            return again != ids.end() ? again->second : addState(target);
+        }
+        int id = addState(target);
+        next[state * numClasses + cls] = id;
+        return id;
+    }
+
+public:
+    size_t statesBuilt = 0;
+    int flushes = 0;
+    bool fallback = false;
+
+    LazyDFA(int start, size_t cap) : nfaStart(start), capacity(max<size_t>(cap, 4)) {
+        numClasses = computeByteClasses(byteClass, representative);
+        reset();
+    }
+
+    int startState() const { return 1; }
+    int acceptOf(int state) const { return accept[state]; }
+
+    int step(int state, unsigned char c) {
+        bytesSinceFlush++;
+        int cls = byteClass[c];
+        int t = next[state * numClasses + cls];
+        return t >= 0 ? t : build(state, cls);
+    }
+
+    // NFA simulation used after fallback: the "state" is the NFA set itself
+    vector<int> startSet() { return epsilonClosure({nfaStart}); }
+    vector<int> stepSet(const vector<int> &set, unsigned char c) { return move(set, byteClass[c]); }
+};
+
+// Same maximal munch loop as scan(), driven by the lazy DFA
+vector<Token> scanLazy(LazyDFA &dfa, const vector<Rule> &rules, const string &text) {
+    vector<Token> tokens;
+    size_t i = 0, n = text.size();
+
+    while (i < n) {
+        int lastRule = -1;
+        size_t lastEnd = i;
+        size_t j = i;
+        if (!dfa.fallback) {
+            int state = dfa.startState();
+            while (j < n) {
+                state = dfa.step(state, text[j]);
+                if (state == 0) break;
+                j++;
+                if (dfa.acceptOf(state) != -1) {
+                    lastRule = dfa.acceptOf(state);
+                    lastEnd = j;
+                }
+            }
+        } else {
+            vector<int> set = dfa.startSet();
+            while (j < n) {
+                set = dfa.stepSet(set, text[j]);
+                if (set.empty()) break;
+                j++;
+                int rule = acceptingRule(set);
+                if (rule != -1) {
+                    lastRule = rule;
+                    lastEnd = j;
+                }
+            }
+        }
+
+        if (lastRule == -1) {
+            tokens.push_back({-1, i, 1});
+            i++;
+            continue;
+        }
+        if (!rules[lastRule].skip) tokens.push_back({lastRule, i, lastEnd - i});
+        i = lastEnd;
+    }
+    return tokens;
+}
+
+int main(int argc, char *argv[]) {
+    // DFAScanner [--lazy cacheStates] [spec] [input]
+    size_t lazyCache = 0;
+    vector<string> args;
+    for (int a = 1; a < argc; a++) {
+        string arg = argv[a];
+        if (arg == "--lazy" && a + 1 < argc) {
+            lazyCache = atol(argv[++a]);
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    string specPath = args.size() > 0 ? args[0] : "Lexer.txt";
+    string code = "int x = 10 + 5;";
+
+    if (args.size() > 1) {
+        ifstream in(args[1], ios::binary);
+        if (!in) {
+            cerr << "Cannot open input file " << args[1] << endl;
+            return 1;
+        }
+        code.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    vector<Rule> rules = readSpec(specPath);
+    if (rules.empty()) {
+        cerr << "No rules found in " << specPath << endl;
+        return 1;
+    }
+
+    int nfaStart = buildNFA(rules);
+
+    cout << "Rules:\n";
+    for (auto &r : rules) {
+        cout << "  " << r.name << (r.skip ? " (skipped)" : "") << " : " << r.regex << "\n";
+    }
+    cout << "NFA states: " << nfa.size() << "\n";
+
+    vector<Token> tokens;
+    if (lazyCache > 0) {
+        LazyDFA lazy(nfaStart, lazyCache);
+        tokens = scanLazy(lazy, rules, code);
+        cout << "Lazy DFA: " << lazy.statesBuilt << " states built, " << lazy.flushes
+             << " cache flushes" << (lazy.fallback ? ", fell back to NFA simulation" : "") << "\n";
+    } else {
+        DFA dfa = subsetConstruction(nfaStart);
+        DFA minDfa = minimize(dfa);
+        cout << "DFA states: " << dfa.numStates << " -> " << minDfa.numStates << " after minimization\n";
+        cout << "Byte classes: " << minDfa.numClasses << "\n";
+        tokens = scan(minDfa, rules, code);
+    }
+
+    if (args.size() <= 1) cout << "\nInput: " << code << "\n";
+    cout << "Tokens:\n";
+    for (auto &t : tokens) {
+        string name = t.rule == -1 ? "UNKNOWN" : rules[t.rule].name;
+        cout << name << ": " << code.substr(t.offset, t.length) << "\n";
+    }
+
+    return 0;
+}
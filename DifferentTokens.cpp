@@ -1,51 +1,712 @@
 #include <iostream>
 #include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <immintrin.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 using namespace std;
 
-int main() {
-    string code = "int x = 10 + 5;";
-    
-    cout << "Input: " << code << "\nTokens:\n";
-    
-    for (int i = 0; i < code.length(); i++) {
+// Character classes used by the scanner (bit flags so runs can mix classes)
+const uint8_t CLASS_SPACE = 1;
+const uint8_t CLASS_ALPHA = 2;
+const uint8_t CLASS_DIGIT = 4;
+const uint8_t CLASS_ALNUM = CLASS_ALPHA | CLASS_DIGIT;
+
+uint8_t charClass[256];
+
+void initCharClasses() {
+    for (int c = 0; c < 256; c++) {
+        charClass[c] = 0;
+        if (isspace(c)) charClass[c] |= CLASS_SPACE;
+        if (isalpha(c)) charClass[c] |= CLASS_ALPHA;
+        if (isdigit(c)) charClass[c] |= CLASS_DIGIT;
+    }
+}
+
+// Each skip function returns the first index >= i whose byte is not in cls
+
+size_t skipScalar(const char *s, size_t i, size_t n, uint8_t cls) {
+    while (i < n && (charClass[(unsigned char)s[i]] & cls)) i++;
+    return i;
+}
+
+// x is in [lo, hi] (unsigned) iff min(x - lo, hi - lo) == x - lo
+__attribute__((target("avx2")))
+static inline __m256i inRange(__m256i x, char lo, char hi) {
+    __m256i t = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(hi - lo)), t);
+}
+
+// 32 bytes per step: build a bitmask of bytes in cls, then count trailing ones
+__attribute__((target("avx2,bmi")))
+size_t skipAVX2(const char *s, size_t i, size_t n, uint8_t cls) {
+    while (i + 32 <= n) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i hit = _mm256_setzero_si256();
+        if (cls & CLASS_SPACE) {
+            hit = _mm256_or_si256(hit, inRange(x, '\t', '\r'));
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+        }
+        if (cls & CLASS_ALPHA) {
+            __m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+            hit = _mm256_or_si256(hit, inRange(lower, 'a', 'z'));
+        }
+        if (cls & CLASS_DIGIT) {
+            hit = _mm256_or_si256(hit, inRange(x, '0', '9'));
+        }
+        uint32_t miss = ~(uint32_t)_mm256_movemask_epi8(hit);
+        if (miss) return i + _tzcnt_u32(miss);
+        i += 32;
+    }
+    return skipScalar(s, i, n, cls);
+}
+
+// 16 bytes per step with PCMPESTRI range matching
+__attribute__((target("sse4.2")))
+size_t skipSSE42(const char *s, size_t i, size_t n, uint8_t cls) {
+    char ranges[16];
+    int len = 0;
+    if (cls & CLASS_SPACE) {
+        ranges[len++] = '\t'; ranges[len++] = '\r';
+        ranges[len++] = ' ';  ranges[len++] = ' ';
+    }
+    if (cls & CLASS_ALPHA) {
+        ranges[len++] = 'a'; ranges[len++] = 'z';
+        ranges[len++] = 'A'; ranges[len++] = 'Z';
+    }
+    if (cls & CLASS_DIGIT) {
+        ranges[len++] = '0'; ranges[len++] = '9';
+    }
+    int rangeLen = len;
+    while (len < 16) ranges[len++] = 0;
+    __m128i r = _mm_loadu_si128((const __m128i *)ranges);
+
+    while (i + 16 <= n) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(s + i));
+        int idx = _mm_cmpestri(r, rangeLen, x, 16,
+                               _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES |
+                               _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT);
+        if (idx < 16) return i + idx;
+        i += 16;
+    }
+    return skipScalar(s, i, n, cls);
+}
+
+// Picked once at startup from the CPU features
+size_t (*skipClass)(const char *, size_t, size_t, uint8_t) = skipScalar;
+
+void selectScanner() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi")) {
+        skipClass = skipAVX2;
+    } else if (__builtin_cpu_supports("sse4.2")) {
+        skipClass = skipSSE42;
+    }
+}
+
+enum TokenKind : uint8_t {
+    KEYWORD,
+    IDENTIFIER,
+    NUMBER,
+    OPERATOR,
+    SEPARATOR
+};
+
+const char *kindNames[] = {"Keyword", "Identifier", "Number", "Operator", "Separator"};
+
+// A token is a slice of the source, no text is copied
+struct Token {
+    TokenKind kind;
+    uint32_t length;
+    size_t offset;
+};
+
+// Keyword list from the KEYWORD definition in Lexer.txt
+struct CKeywords {
+    static constexpr string_view words[] = {
+        "int", "float", "char", "double", "if", "else", "while", "for", "return"
+    };
+};
+
+// Perfect hash on (length, first char, last char), found at compile time.
+// A lookup is one hash, one length check and one memcmp.
+template <typename Keywords>
+class KeywordTable {
+private:
+    static constexpr size_t COUNT = size(Keywords::words);
+    static constexpr size_t MAX_SIZE = 256;
+
+    struct Params {
+        size_t size = 0;    // power of two
+        uint32_t a = 0, b = 0, c = 0;
+        uint8_t slot[MAX_SIZE] = {};   // word index + 1, 0 = empty
+    };
+
+    static constexpr uint32_t hash(size_t len, unsigned char first, unsigned char last,
+                                   uint32_t a, uint32_t b, uint32_t c, size_t size) {
+        return (uint32_t)(len * a + first * b + last * c) & (size - 1);
+    }
+
+    static constexpr Params search() {
+        for (size_t size = 8; size <= MAX_SIZE; size *= 2) {
+            if (size < COUNT) continue;
+            for (uint32_t a = 1; a < 32; a++)
+                for (uint32_t b = 1; b < 32; b++)
+                    for (uint32_t c = 0; c < 32; c++) {
+                        Params p;
+                        p.size = size; p.a = a; p.b = b; p.c = c;
+                        bool ok = true;
+                        for (size_t i = 0; i < COUNT && ok; i++) {
+                            string_view w = Keywords::words[i];
+                            uint32_t h = hash(w.size(), w.front(), w.back(), a, b, c, size);
+                            if (p.slot[h]) ok = false;
+                            else p.slot[h] = i + 1;
+                        }
+                        if (ok) return p;
+                    }
+        }
+        return Params();
+    }
+
+    static constexpr Params params = search();
+    static_assert(params.size != 0, "no perfect hash found for keyword list");
+
+public:
+    static bool contains(string_view token) {
+        if (token.empty()) return false;
+        uint32_t h = hash(token.size(), token.front(), token.back(),
+                          params.a, params.b, params.c, params.size);
+        uint8_t slot = params.slot[h];
+        if (!slot) return false;
+        string_view w = Keywords::words[slot - 1];
+        return w.size() == token.size() && memcmp(w.data(), token.data(), w.size()) == 0;
+    }
+};
+
+bool isKeyword(string_view token) {
+    return KeywordTable<CKeywords>::contains(token);
+}
+
+// The comparison chain the scanner used before the hash table (kept for --bench-keywords)
+bool isKeywordChain(string_view token) {
+    return token == "int" || token == "float" || token == "char" ||
+           token == "double" || token == "if" || token == "else" ||
+           token == "while" || token == "for" || token == "return";
+}
+
+// Times the three keyword lookups over a mix of keywords and identifiers
+void benchKeywords() {
+    vector<string> words;
+    mt19937 rng(42);
+    const char *letters = "abcdefghijklmnopqrstuvwxyz";
+    for (int i = 0; i < 1000000; i++) {
+        if (rng() % 3 == 0) {
+            words.push_back(string(CKeywords::words[rng() % size(CKeywords::words)]));
+        } else {
+            string w;
+            int len = 1 + rng() % 8;
+            for (int k = 0; k < len; k++) w += letters[rng() % 26];
+            words.push_back(w);
+        }
+    }
+    vector<string_view> views(words.begin(), words.end());
+    unordered_set<string_view> set(begin(CKeywords::words), end(CKeywords::words));
+
+    auto run = [&](const char *name, auto lookup) {
+        auto start = chrono::steady_clock::now();
+        size_t hits = 0;
+        for (int round = 0; round < 10; round++)
+            for (string_view w : views) hits += lookup(w);
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        cout << name << ": " << ns / (10.0 * views.size()) << " ns/lookup (" << hits << " hits)\n";
+    };
+
+    run("comparison chain", isKeywordChain);
+    run("unordered_set", [&](string_view w) { return set.count(w) != 0; });
+    run("perfect hash", isKeyword);
+}
+
+// Lexes s[i..n) into out until it holds limit tokens; returns where it stopped.
+// Offsets of characters that start no token are added to unknown if given.
+size_t lex(const char *s, size_t n, size_t i, vector<Token> &out, size_t limit,
+           vector<size_t> *unknown = nullptr) {
+    while (i < n && out.size() < limit) {
+        uint8_t cls = charClass[(unsigned char)s[i]];
+
         // Skip spaces
-        if (isspace(code[i])) continue;
-        
+        if (cls & CLASS_SPACE) {
+            i = skipClass(s, i, n, CLASS_SPACE);
+            continue;
+        }
+
         // Check for keywords/identifiers
-        if (isalpha(code[i])) {
-            string token = "";
-            while (i < code.length() && isalnum(code[i])) {
-                token += code[i++];
-            }
-            i--;
-            
-            // Check if it's a keyword
-            if (token == "int" || token == "float" || token == "if" || 
-                token == "else" || token == "while" || token == "return") {
-                cout << "Keyword: " << token << endl;
-            } else {
-                cout << "Identifier: " << token << endl;
-            }
+        if (cls & CLASS_ALPHA) {
+            size_t start = i;
+            i = skipClass(s, i, n, CLASS_ALNUM);
+            TokenKind kind = isKeyword(string_view(s + start, i - start)) ? KEYWORD : IDENTIFIER;
+            out.push_back({kind, (uint32_t)(i - start), start});
+            continue;
         }
         // Check for numbers
-        else if (isdigit(code[i])) {
-            string token = "";
-            while (i < code.length() && isdigit(code[i])) {
-                token += code[i++];
-            }
-            i--;
-            cout << "Number: " << token << endl;
+        if (cls & CLASS_DIGIT) {
+            size_t start = i;
+            i = skipClass(s, i, n, CLASS_DIGIT);
+            out.push_back({NUMBER, (uint32_t)(i - start), start});
+            continue;
         }
         // Check for operators
-        else if (code[i] == '+' || code[i] == '-' || code[i] == '*' || 
-                 code[i] == '/' || code[i] == '=') {
-            cout << "Operator: " << code[i] << endl;
+        if (s[i] == '+' || s[i] == '-' || s[i] == '*' ||
+            s[i] == '/' || s[i] == '=') {
+            out.push_back({OPERATOR, 1, i});
         }
         // Check for separators
-        else if (code[i] == ';' || code[i] == ',' || code[i] == '(' || code[i] == ')') {
-            cout << "Separator: " << code[i] << endl;
+        else if (s[i] == ';' || s[i] == ',' || s[i] == '(' || s[i] == ')') {
+            out.push_back({SEPARATOR, 1, i});
+        }
+        else if (unknown) {
+            unknown->push_back(i);
+        }
+        i++;
+    }
+    return i;
+}
+
+// An edit of the source: removed bytes at offset are replaced by inserted
+struct Edit {
+    size_t offset;
+    size_t removed;
+    string inserted;
+};
+
+// Tokens [first, first + oldCount) of the old stream were replaced by
+// [first, first + newCount) of the new one
+struct RelexResult {
+    size_t first;
+    size_t oldCount;
+    size_t newCount;
+};
+
+// Applies edit to text and re-lexes only the damaged region of tokens.
+// Lexing restarts at the last token boundary before the edit and stops as soon
+// as a new token starts where an old token starts in the untouched text after
+// the edit; from there on the lexer (which has no state between tokens)
+// would reproduce the old tokens shifted by the size change.
+// The lexing work is proportional to the damage, but the text and token
+// splices and the offset shift of the later tokens are still linear in the
+// size of the tail, so an edit near the start of a large file costs a
+// memmove-speed pass over it.
+RelexResult relex(string &text, vector<Token> &tokens, const Edit &edit) {
+    size_t editEnd = edit.offset + edit.removed;    // in old coordinates
+    long long delta = (long long)edit.inserted.size() - (long long)edit.removed;
+
+    // first token that ends at or after the edit
+    size_t first = lower_bound(tokens.begin(), tokens.end(), edit.offset,
+                               [](const Token &t, size_t off) { return t.offset + t.length < off; }) - tokens.begin();
+    size_t restart = first < tokens.size() ? min(tokens[first].offset, edit.offset) : edit.offset;
+
+    text.replace(edit.offset, edit.removed, edit.inserted);
+
+    // a token glued to the restart point may merge with what follows, but only
+    // across two alphanumerics (as in nextSafeBoundary), so step back over those
+    while (first > 0 && restart < text.size() && tokens[first - 1].offset + tokens[first - 1].length == restart &&
+           (charClass[(unsigned char)text[restart - 1]] & CLASS_ALNUM) &&
+           (charClass[(unsigned char)text[restart]] & CLASS_ALNUM)) {
+        first--;
+        restart = tokens[first].offset;
+    }
+
+    // old tokens that start in the untouched tail are resync candidates
+    size_t old = lower_bound(tokens.begin() + first, tokens.end(), editEnd,
+                             [](const Token &t, size_t off) { return t.offset < off; }) - tokens.begin();
+
+    vector<Token> fresh;
+    const char *s = text.data();
+    size_t n = text.size();
+    size_t pos = restart;
+    size_t resync = tokens.size();
+    while (pos < n) {
+        size_t before = fresh.size();
+        pos = lex(s, n, pos, fresh, before + 1);
+        if (fresh.size() == before) break;
+        size_t start = fresh.back().offset;
+        while (old < tokens.size() && tokens[old].offset + delta < start) old++;
+        if (old < tokens.size() && tokens[old].offset + delta == start) {
+            fresh.pop_back();
+            resync = old;
+            break;
+        }
+    }
+
+    for (size_t t = resync; t < tokens.size(); t++) tokens[t].offset += delta;
+    tokens.erase(tokens.begin() + first, tokens.begin() + resync);
+    tokens.insert(tokens.begin() + first, fresh.begin(), fresh.end());
+    return {first, resync - first, fresh.size()};
+}
+
+// Interns identifier text and hands out dense 32-bit ids.
+// Names are copied into fixed-size blocks that never move, so the
+// string_view keys of the index stay valid.
+class StringPool {
+private:
+    static constexpr size_t BLOCK_SIZE = 1 << 16;
+    vector<unique_ptr<char[]>> blocks;
+    size_t blockUsed = BLOCK_SIZE;
+    unordered_map<string_view, uint32_t> index;
+    vector<string_view> names;
+
+    string_view store(string_view text) {
+        if (text.size() > BLOCK_SIZE) {
+            // its own block, kept in front of the one being filled
+            auto big = blocks.insert(blocks.empty() ? blocks.end() : blocks.end() - 1,
+                                     unique_ptr<char[]>(new char[text.size()]));
+            memcpy(big->get(), text.data(), text.size());
+            return string_view(big->get(), text.size());
+        }
+        if (blockUsed + text.size() > BLOCK_SIZE) {
+            blocks.emplace_back(new char[BLOCK_SIZE]);
+            blockUsed = 0;
+        }
+        char *dst = blocks.back().get() + blockUsed;
+        memcpy(dst, text.data(), text.size());
+        blockUsed += text.size();
+        return string_view(dst, text.size());
+    }
+
+public:
+    uint32_t intern(string_view text) {
+        auto it = index.find(text);
+        if (it != index.end()) return it->second;
+        string_view saved = store(text);
+        uint32_t id = names.size();
+        names.push_back(saved);
+        index.emplace(saved, id);
+        return id;
+    }
+
+    string_view name(uint32_t id) const {
+        return names[id];
+    }
+
+    size_t size() const {
+        return names.size();
+    }
+};
+
+// Struct-of-arrays token storage for the later stages: each field is a
+// separate contiguous array, and keywords/identifiers carry their pool id
+struct TokenBuffer {
+    static constexpr uint32_t NO_ID = UINT32_MAX;
+
+    vector<TokenKind> kinds;
+    vector<size_t> offsets;
+    vector<uint32_t> lengths;
+    vector<uint32_t> ids;
+    StringPool pool;
+
+    TokenBuffer() {
+        // keywords get the first ids so parsers can compare against constants
+        for (string_view kw : CKeywords::words) pool.intern(kw);
+    }
+
+    size_t size() const {
+        return kinds.size();
+    }
+
+    void append(const char *s, const vector<Token> &tokens) {
+        for (const Token &t : tokens) {
+            kinds.push_back(t.kind);
+            offsets.push_back(t.offset);
+            lengths.push_back(t.length);
+            if (t.kind == KEYWORD || t.kind == IDENTIFIER) {
+                ids.push_back(pool.intern(string_view(s + t.offset, t.length)));
+            } else {
+                ids.push_back(NO_ID);
+            }
+        }
+    }
+};
+
+// Every token is a run of alphanumerics or a single character, so a token
+// can only straddle position p when both s[p - 1] and s[p] are alphanumeric
+size_t nextSafeBoundary(const char *s, size_t n, size_t p) {
+    while (p > 0 && p < n && (charClass[(unsigned char)s[p - 1]] & CLASS_ALNUM) &&
+           (charClass[(unsigned char)s[p]] & CLASS_ALNUM)) {
+        p++;
+    }
+    return p;
+}
+
+// Lexes s[begin..end) on several threads; each chunk starts at a safe boundary,
+// so the per-thread results only need to be concatenated in order
+void lexParallel(const char *s, size_t begin, size_t end, int threads, vector<Token> &out,
+                 vector<size_t> *unknown = nullptr) {
+    vector<size_t> cuts = {begin};
+    for (int t = 1; t < threads; t++) {
+        size_t p = nextSafeBoundary(s, end, begin + (end - begin) * t / threads);
+        cuts.push_back(max(p, cuts.back()));
+    }
+    cuts.push_back(end);
+
+    vector<vector<Token>> parts(threads);
+    vector<vector<size_t>> unknownParts(threads);
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            parts[t].reserve((cuts[t + 1] - cuts[t]) / 4);
+            lex(s, cuts[t + 1], cuts[t], parts[t], SIZE_MAX, unknown ? &unknownParts[t] : nullptr);
+        });
+    }
+    for (auto &w : workers) w.join();
+
+    if (unknown) {
+        for (auto &part : unknownParts) unknown->insert(unknown->end(), part.begin(), part.end());
+    }
+
+    size_t total = 0;
+    for (auto &part : parts) total += part.size();
+    out.clear();
+    out.reserve(total);
+    for (auto &part : parts) out.insert(out.end(), part.begin(), part.end());
+}
+
+// Offsets of every '\n' in the source, so that a byte offset can be turned
+// into line:column by binary search. The lexer itself never counts lines;
+// the index is only built once something needs a position.
+class NewlineIndex {
+private:
+    vector<size_t> newlines;
+
+    __attribute__((target("avx2,popcnt,bmi")))
+    void buildAVX2(const char *s, size_t n) {
+        const __m256i nl = _mm256_set1_epi8('\n');
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(s + i));
+            uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, nl));
+            if (!mask) continue;
+            size_t at = newlines.size();
+            newlines.resize(at + _mm_popcnt_u32(mask));
+            while (mask) {
+                newlines[at++] = i + _tzcnt_u32(mask);
+                mask &= mask - 1;
+            }
+        }
+        buildScalar(s + i, n - i, i);
+    }
+
+    void buildScalar(const char *s, size_t n, size_t base) {
+        const char *p = s, *end = s + n;
+        while ((p = (const char *)memchr(p, '\n', end - p)) != nullptr) {
+            newlines.push_back(base + (p - s));
+            p++;
+        }
+    }
+
+public:
+    bool built = false;
+
+    void build(const char *s, size_t n) {
+        newlines.clear();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt") &&
+            __builtin_cpu_supports("bmi")) {
+            buildAVX2(s, n);
+        } else {
+            buildScalar(s, n, 0);
+        }
+        built = true;
+    }
+
+    // 1-based line and column of a byte offset
+    pair<size_t, size_t> lineColumn(size_t offset) const {
+        size_t line = lower_bound(newlines.begin(), newlines.end(), offset) - newlines.begin();
+        size_t lineStart = line == 0 ? 0 : newlines[line - 1] + 1;
+        return {line + 1, offset - lineStart + 1};
+    }
+};
+
+// Source text either mapped from a file or read into one buffer (pipes, stdin)
+struct Source {
+    const char *data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    string buffer;
+};
+
+bool openSource(const char *path, Source &src) {
+    int fd = string(path) == "-" ? 0 : open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            src.data = (const char *)p;
+            src.size = st.st_size;
+            src.mapped = true;
+            if (fd != 0) close(fd);
+            return true;
+        }
+    }
+
+    // Not mappable: read in large blocks
+    const size_t BLOCK = 1 << 20;
+    ssize_t got;
+    do {
+        size_t used = src.buffer.size();
+        src.buffer.resize(used + BLOCK);
+        got = read(fd, &src.buffer[used], BLOCK);
+        src.buffer.resize(used + (got > 0 ? got : 0));
+    } while (got > 0);
+    if (fd != 0) close(fd);
+
+    src.data = src.buffer.data();
+    src.size = src.buffer.size();
+    return got == 0;
+}
+
+void closeSource(Source &src) {
+    if (src.mapped) munmap((void *)src.data, src.size);
+}
+
+int main(int argc, char *argv[]) {
+    initCharClasses();
+    selectScanner();
+
+    if (argc > 1 && string(argv[1]) == "--bench-keywords") {
+        benchKeywords();
+        return 0;
+    }
+
+    // DifferentTokens [-j threads] [--intern | --count] [--edit offset removed text] [file | -]
+    int threads = 1;
+    bool intern = false;
+    bool countOnly = false;
+    bool editMode = false;
+    Edit edit;
+    const char *path = nullptr;
+    for (int a = 1; a < argc; a++) {
+        string arg = argv[a];
+        if (arg == "-j" && a + 1 < argc) {
+            threads = max(1, atoi(argv[++a]));
+        } else if (arg == "--edit" && a + 3 < argc) {
+            editMode = true;
+            edit.offset = atoll(argv[++a]);
+            edit.removed = atoll(argv[++a]);
+            edit.inserted = argv[++a];
+        } else if (arg == "--intern") {
+            intern = true;
+        } else if (arg == "--count") {
+            countOnly = true;
+        } else {
+            path = argv[a];
+        }
+    }
+
+    string code = "int x = 10 + 5;";
+    Source src;
+    if (path) {
+        // File mode: DifferentTokens <file>, or - for stdin
+        if (!openSource(path, src)) {
+            cerr << "Cannot read " << path << endl;
+            return 1;
         }
+    } else {
+        src.data = code.data();
+        src.size = code.size();
+        cout << "Input: " << code << "\n";
     }
-    
+
+    // --edit lexes the input, applies the edit and re-lexes only the damaged tokens
+    if (editMode) {
+        string text(src.data, src.size);
+        closeSource(src);
+        if (edit.offset > text.size() || edit.offset + edit.removed > text.size()) {
+            cerr << "Edit is outside the input" << endl;
+            return 1;
+        }
+        vector<Token> tokens;
+        lex(text.data(), text.size(), 0, tokens, SIZE_MAX);
+        RelexResult r = relex(text, tokens, edit);
+
+        cout << "Edited: " << text << "\n";
+        cout << "Replaced tokens [" << r.first << ", " << r.first + r.oldCount << ") with "
+             << r.newCount << " new token(s):\n";
+        for (size_t t = r.first; t < r.first + r.newCount; t++) {
+            cout << kindNames[tokens[t].kind] << ": " << string_view(text.data() + tokens[t].offset, tokens[t].length) << '\n';
+        }
+        return 0;
+    }
+
+    if (!countOnly) cout << "Tokens:\n";
+
+    // Tokens are printed in batches so memory stays bounded by the batch size
+    const size_t BATCH = 1 << 16;
+    // In parallel mode each thread gets a chunk of this many bytes per window
+    const size_t CHUNK = 8 << 20;
+    vector<Token> tokens;
+    tokens.reserve(BATCH);
+    TokenBuffer buffer;
+    NewlineIndex lines;
+    vector<size_t> unknown;
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < src.size) {
+        unknown.clear();
+        if (threads > 1) {
+            size_t end = nextSafeBoundary(src.data, src.size, min(src.size, pos + CHUNK * threads));
+            lexParallel(src.data, pos, end, threads, tokens, &unknown);
+            pos = end;
+        } else {
+            tokens.clear();
+            pos = lex(src.data, src.size, pos, tokens, BATCH, &unknown);
+        }
+        // only diagnostics look up positions
+        for (size_t off : unknown) {
+            if (!lines.built) lines.build(src.data, src.size);
+            auto lc = lines.lineColumn(off);
+            cerr << lc.first << ":" << lc.second << ": unknown character '" << src.data[off] << "'\n";
+        }
+        count += tokens.size();
+        if (countOnly) continue;
+        if (intern) {
+            buffer.append(src.data, tokens);
+            continue;
+        }
+        for (const Token &t : tokens) {
+            cout << kindNames[t.kind] << ": " << string_view(src.data + t.offset, t.length) << '\n';
+        }
+    }
+
+    // --intern keeps the whole token stream and prints it by id
+    if (intern) {
+        for (size_t t = 0; t < buffer.size(); t++) {
+            cout << kindNames[buffer.kinds[t]] << ": ";
+            if (buffer.ids[t] != TokenBuffer::NO_ID) {
+                cout << "#" << buffer.ids[t] << " " << buffer.pool.name(buffer.ids[t]) << '\n';
+            } else {
+                cout << string_view(src.data + buffer.offsets[t], buffer.lengths[t]) << '\n';
+            }
+        }
+        cout << buffer.size() << " tokens, " << buffer.pool.size() << " interned names\n";
+    }
+    // --count only reports the number of tokens (used by LexerBench)
+    if (countOnly) cout << count << "\n";
+
+    closeSource(src);
     return 0;
-}
\ No newline at end of file
+}
@@ -1,70 +1,10 @@
 #include <bits/stdc++.h>
+#include "Grammar.h"
+#include "IncrementalGrammar.h"
+#include "GrammarFile.h"
+#include "GrammarStats.h"
 using namespace std;
 
-map<char, vector<string>> grammar;
-map<char, set<char>> firstSet;
-
-bool isTerminal(char c) {
-    return !(c >= 'A' && c <= 'Z');
-}
-
-set<char> findFirst(string production) {
-    set<char> res;
-    
-    if (production == "#") {
-        res.insert('#');
-        return res;
-    }
-    
-    for (int i = 0; i < production.size(); i++) {
-        char curr = production[i];
-        
-        if (isTerminal(curr)) {
-            res.insert(curr);
-            break;
-        }
-        
-        bool hasEpsilon = false;
-        for (char ch : firstSet[curr]) {
-            if (ch == '#') {
-                hasEpsilon = true;
-            } else {
-                res.insert(ch);
-            }
-        }
-        
-        if (!hasEpsilon) {
-            break;
-        }
-        
-        if (i == production.size() - 1) {
-            res.insert('#');
-        }
-    }
-    
-    return res;
-}
-
-bool findFirstSets() {
-    bool isChanged = false;
-    
-    for (auto p : grammar) {
-        char symbol = p.first;
-        
-        for (string production : grammar[symbol]) {
-            auto res = findFirst(production);
-            size_t before = firstSet[symbol].size();
-            firstSet[symbol].insert(res.begin(), res.end());
-            
-            if (firstSet[symbol].size() > before) {
-                isChanged = true;
-            }
-        }
-    }
-    
-    return isChanged;
-}
-
 string modifyInput(string input) {
     size_t pos = 0;
     
@@ -86,45 +26,114 @@ string modifyOutput(string output) {
     return output;
 }
 
-int main() {
+// Prints FIRST of every nonterminal, in name order
+void printFirst(const IncrementalGrammar &inc) {
+    for (const string &a : inc.nonTerminals()) {
+        cout << "\nFIRST(" << a << ") = { ";
+        for (const string &s : inc.firstOf(a))
+            cout << modifyOutput(s) << " ";
+        cout << "}";
+    }
+    cout << "\n";
+}
+
+// Reads "+ LHS->alt|alt" / "- LHS->alt|alt" lines until end of input,
+// updating FIRST incrementally and printing it after every edit
+void editGrammar(IncrementalGrammar &inc) {
+    string line;
+    while (getline(cin, line)) {
+        if (line.size() < 2 || (line[0] != '+' && line[0] != '-')) continue;
+        GrammarBuilder edit;
+        if (!edit.addLine(modifyInput(line.substr(1)))) {
+            cout << "Expected a production after " << line[0] << "\n";
+            continue;
+        }
+        size_t evaluations = 0;
+        for (auto &p : edit.productions()) {
+            if (line[0] == '+') {
+                inc.addProduction(p.first, p.second);
+            } else if (!inc.removeProduction(p.first, p.second)) {
+                cout << "No such production:" << line.substr(1) << "\n";
+            }
+            evaluations += inc.lastEvaluations();
+        }
+        cout << "\nFIRST sets after " << line << " (" << evaluations << " rows evaluated):\n";
+        printFirst(inc);
+    }
+}
+
+int main(int argc, char *argv[]) {
     int n;
-    char startSymbol;
+    GrammarBuilder grammar;
     
-    cout << "Enter the number of productions: ";
-    cin >> n;
-    cin.ignore();
+    // -j N solves the FIRST/FOLLOW inclusion graphs on N threads
+    // --edit keeps reading "+ production" / "- production" lines after the grammar
+    // --grammar file reads the grammar from a file instead of prompting (see GrammarFile.h)
+    // --stats prints phase timings instead of the result (see GrammarStats.h)
+    int threads = 1;
+    bool edit = false;
+    const char *grammarFile = nullptr;
+    bool stats = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) threads = max(1, atoi(argv[++i]));
+        else if (arg == "--edit") edit = true;
+        else if (arg == "--grammar" && i + 1 < argc) grammarFile = argv[++i];
+        else if (arg == "--stats") stats = true;
+    }
     
-    for (int i = 0; i < n; i++) {
-        cout << "Enter the production " << i + 1 << ": ";
-        string production;
-        getline(cin, production);
-        production = modifyInput(production);
-        
-        char lhs = production[0];
-        string rhs = production.substr(3);
-        
+    Grammar g;
+    if (grammarFile) {
+        string error;
+        if (!loadGrammarFile(grammarFile, g, error)) {
+            cerr << error << "\n";
+            return 1;
+        }
+    } else {
+        cout << "Enter the number of productions: ";
+        cin >> n;
+        cin.ignore();
+    
+        for (int i = 0; i < n; i++) {
+            cout << "Enter the production " << i + 1 << ": ";
+            string production;
+            getline(cin, production);
+            production = modifyInput(production);
         
-        string temp = "";
-        for (char c : rhs) {
-            if (c == '|') {
-                grammar[lhs].push_back(temp);
-                temp = "";
-            } else {
-                temp += c;
-            }
+            // the first production's left-hand side is the start symbol
+            grammar.addLine(production);
         }
-        grammar[lhs].push_back(temp);
+        g = grammar.build();
     }
     
+    if (edit) {
+        IncrementalGrammar inc;
+        inc.addProductions(g);
+        cout << "\nFIRST sets:\n";
+        printFirst(inc);
+        editGrammar(inc);
+        return 0;
+    }
+
+    if (stats) {
+        PhaseStats phases;
+        countGrammar(phases, g);
+        phases.start();
+        computeFirst(g, threads);
+        phases.stop("first");
+        phases.print();
+        return 0;
+    }
+
     // Calculate FIRST sets
-    while (findFirstSets());
+    BitMatrix first = computeFirst(g, threads);
 
     // Display FIRST sets
     cout << "\nFIRST sets:\n";
-    for (auto p : grammar) {
-        cout << "\nFIRST(" << p.first << ") = { ";
-        for (char s : firstSet[p.first])
-            cout << modifyOutput(string(1, s)) << " ";
+    for (int a = 0; a < g.numNonTerminals(); a++) {
+        cout << "\nFIRST(" << g.names[g.nonTerminal(a)] << ") = { ";
+        for (const string &s : setSymbols(g, first, g.nonTerminal(a)))
+            cout << modifyOutput(s) << " ";
         cout << "}";
     }
     return 0;
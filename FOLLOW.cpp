@@ -1,150 +1,13 @@
 #include <bits/stdc++.h>
+#include "Grammar.h"
+#include "IncrementalGrammar.h"
+#include "GrammarFile.h"
+#include "GrammarStats.h"
 
 using namespace std;
 
 // Run chcp 65001 to enable unicode input
 
-map<char, vector<string>> grammar;
-set<char> terminals;
-map<char, set<char>> followSet;
-map<char, set<char>> firstSet;
-// map<pair<char, char>, set<int>> parseTable;
-
-bool isTerminal(char c) {
-    return !(c >= 'A' && c <= 'Z');
-}
-
-set<char> findFirst(string production) {
-    set<char> res;
-    
-    if (production == "#") {
-        res.insert('#');
-        return res;
-    }
-    
-    for (int i = 0; i < production.size(); i++) {
-        char curr = production[i];
-        
-        if (isTerminal(curr)) {
-            res.insert(curr);
-            break;
-        }
-        
-        bool hasEpsilon = false;
-        for (char ch : firstSet[curr]) {
-            if (ch == '#') {
-                hasEpsilon = true;
-            } else {
-                res.insert(ch);
-            }
-        }
-        
-        if (!hasEpsilon) {
-            break;
-        }
-        
-        if (i == production.size() - 1) {
-            res.insert('#');
-        }
-    }
-    
-    return res;
-}
-
-bool findFirstSets() {
-    bool isChanged = false;
-    
-    for (auto p : grammar) {
-        char symbol = p.first;
-        
-        for (string production : grammar[symbol]) {
-            auto res = findFirst(production);
-            size_t before = firstSet[symbol].size();
-            firstSet[symbol].insert(res.begin(), res.end());
-            
-            if (firstSet[symbol].size() > before) {
-                isChanged = true;
-            }
-        }
-    }
-    
-    return isChanged;
-}
-
-bool findFollowSets() {
-    bool isChanged = false;
-    
-    for (auto p : grammar) {
-        char symbol = p.first;
-        
-        for (string production : grammar[symbol]) {
-            if (production == "#")
-                continue;
-            
-            // Process all symbols except the last one
-            for (int i = 0; i < production.size() - 1; i++) {
-                char currSymbol = production[i];
-                
-                if (isTerminal(production[i])) {
-                    continue;
-                }
-                
-                for (int j = i + 1; j < production.size(); j++) {
-                    bool hasEpsilon = false;
-                    char nextSymbol = production[j];
-                    
-                    if (isTerminal(production[j])) {
-                        auto result = followSet[currSymbol].insert(nextSymbol);
-                        if (result.second) {
-                            isChanged = true;
-                        }
-                        break;
-                    } else {
-                        for (char first : firstSet[production[j]]) {
-                            if (first == '#') {
-                                hasEpsilon = true;
-                            } else {
-                                auto result = followSet[currSymbol].insert(first);
-                                if (result.second) {
-                                    isChanged = true;
-                                }
-                            }
-                        }
-                    }
-                    
-                    if (!hasEpsilon)
-                        break;
-                    
-                    if (j == production.size() - 1) {
-                        size_t before = followSet[currSymbol].size();
-                        followSet[currSymbol].insert(
-                            followSet[symbol].begin(),
-                            followSet[symbol].end()
-                        );
-                        if (followSet[currSymbol].size() > before) {
-                            isChanged = true;
-                        }
-                    }
-                }
-            }
-            
-            // Process last symbol
-            char lastSymbol = production[production.size() - 1];
-            if (!isTerminal(lastSymbol)) {
-                size_t before = followSet[lastSymbol].size();
-                followSet[lastSymbol].insert(
-                    followSet[symbol].begin(),
-                    followSet[symbol].end()
-                );
-                if (followSet[lastSymbol].size() > before) {
-                    isChanged = true;
-                }
-            }
-        }
-    }
-    
-    return isChanged;
-}
 string modifyInput(string input) {
     size_t pos = 0;
     
@@ -166,55 +29,117 @@ string modifyOutput(string output) {
     return output;
 }
 
-int main() {
+// Prints FOLLOW of every nonterminal, in name order
+void printFollow(const IncrementalGrammar &inc) {
+    for (const string &a : inc.nonTerminals()) {
+        cout << "FOLLOW(" << a << ") = { ";
+        for (const string &s : inc.followOf(a))
+            cout << s << " ";
+        cout << "}\n";
+    }
+}
+
+// Reads "+ LHS->alt|alt" / "- LHS->alt|alt" lines until end of input,
+// updating FOLLOW incrementally and printing it after every edit
+void editGrammar(IncrementalGrammar &inc) {
+    string line;
+    while (getline(cin, line)) {
+        if (line.size() < 2 || (line[0] != '+' && line[0] != '-')) continue;
+        GrammarBuilder edit;
+        if (!edit.addLine(line.substr(1))) {
+            cout << "Expected a production after " << line[0] << "\n";
+            continue;
+        }
+        size_t evaluations = 0;
+        for (auto &p : edit.productions()) {
+            if (line[0] == '+') {
+                inc.addProduction(p.first, p.second);
+            } else if (!inc.removeProduction(p.first, p.second)) {
+                cout << "No such production:" << line.substr(1) << "\n";
+            }
+            evaluations += inc.lastEvaluations();
+        }
+        cout << "\nFOLLOW sets after " << line << " (" << evaluations << " rows evaluated):\n";
+        printFollow(inc);
+    }
+}
+
+int main(int argc, char *argv[]) {
     int n;
-    char startSymbol;
-    
-    cout << "Enter the number of productions: ";
-    cin >> n;
-    cin.ignore();
+    GrammarBuilder grammar;
+    
+    // -j N solves the FIRST/FOLLOW inclusion graphs on N threads
+    // --edit keeps reading "+ production" / "- production" lines after the grammar
+    // --grammar file reads the grammar from a file instead of prompting (see GrammarFile.h)
+    // --stats prints phase timings instead of the result (see GrammarStats.h)
+    int threads = 1;
+    bool edit = false;
+    const char *grammarFile = nullptr;
+    bool stats = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) threads = max(1, atoi(argv[++i]));
+        else if (arg == "--edit") edit = true;
+        else if (arg == "--grammar" && i + 1 < argc) grammarFile = argv[++i];
+        else if (arg == "--stats") stats = true;
+    }
     
-    for (int i = 0; i < n; i++) {
-        cout << "Enter the production " << i + 1 << ": ";
-        string production;
-        getline(cin, production);
-        // production = modifyInput(production);
-        
-        char lhs = production[0];
-        string rhs = production.substr(3);
-        
-         
+    Grammar g;
+    if (grammarFile) {
+        string error;
+        if (!loadGrammarFile(grammarFile, g, error)) {
+            cerr << error << "\n";
+            return 1;
+        }
+    } else {
+        cout << "Enter the number of productions: ";
+        cin >> n;
+        cin.ignore();
+    
+        for (int i = 0; i < n; i++) {
+            cout << "Enter the production " << i + 1 << ": ";
+            string production;
+            getline(cin, production);
+            // production = modifyInput(production);
         
-        string temp = "";
-        for (char c : rhs) {
-            if (c == '|') {
-                grammar[lhs].push_back(temp);
-                temp = "";
-            } else {
-                temp += c;
-                if (isTerminal(c) && c != '#') {
-                    terminals.insert(c);
-                }
-            }
+            // the first production's left-hand side is the start symbol
+            grammar.addLine(production);
         }
-        grammar[lhs].push_back(temp);
+        g = grammar.build();
     }
     
+    if (edit) {
+        IncrementalGrammar inc;
+        inc.addProductions(g);
+        cout << "\nFOLLOW sets:\n";
+        printFollow(inc);
+        editGrammar(inc);
+        return 0;
+    }
+
+    if (stats) {
+        PhaseStats phases;
+        countGrammar(phases, g);
+        phases.start();
+        BitMatrix first = computeFirst(g, threads);
+        phases.stop("first");
+        computeFollow(g, first, threads);
+        phases.stop("follow");
+        phases.print();
+        return 0;
+    }
+
     // Calculate FIRST sets
-    while (findFirstSets());
-    
-    // Initialize FOLLOW set for start symbol
-    followSet[startSymbol].insert('$');
-    terminals.insert('$');
+    BitMatrix first = computeFirst(g, threads);
     
-    // Calculate FOLLOW sets
-    while (findFollowSets());
+    // Calculate FOLLOW sets ('$' goes into FOLLOW of the start symbol)
+    BitMatrix follow = computeFollow(g, first, threads);
 
     // Display FOLLOW sets
     cout << "\nFOLLOW sets:\n";
-    for (auto p : grammar) {
-        cout << "FOLLOW(" << p.first << ") = { ";
-        for (char s : followSet[p.first])
+    for (int a = 0; a < g.numNonTerminals(); a++) {
+        cout << "FOLLOW(" << g.names[g.nonTerminal(a)] << ") = { ";
+        for (const string &s : setSymbols(g, follow, g.nonTerminal(a)))
             cout << s << " ";
         cout << "}\n";
     }
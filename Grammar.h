@@ -0,0 +1,658 @@
+#pragma once
+
+#include <bits/stdc++.h>
+using namespace std;
+
+// Shared grammar model for the FIRST/FOLLOW, LL(1) and LR tools
+//
+// Symbol names are interned to dense integer ids. Terminals (including "#"
+// for epsilon and "$" for end of input) come first in name order, then
+// nonterminals. Productions are flat arrays of ids, with an index from each
+// nonterminal to the range of its productions.
+// FIRST and FOLLOW are rows of one contiguous bit matrix, indexed by
+// nonterminal, with one bit per terminal id, so a set union is a word-wise OR.
+// Both are solved in a single pass over their inclusion graphs (see digraph()).
+
+// Fixed-width bitsets stored back to back in one array
+class BitMatrix {
+public:
+    int rows = 0;
+    int words = 0;  // 64-bit words per row
+    vector<uint64_t> bits;
+
+    BitMatrix() {}
+    BitMatrix(int r, int cols) : rows(r), words((cols + 63) / 64), bits((size_t)r * words, 0) {}
+
+    uint64_t *row(int r) { return bits.data() + (size_t)r * words; }
+    const uint64_t *row(int r) const { return bits.data() + (size_t)r * words; }
+
+    void set(int r, int c) { row(r)[c >> 6] |= 1ULL << (c & 63); }
+    bool test(int r, int c) const { return (row(r)[c >> 6] >> (c & 63)) & 1; }
+
+    // row r |= src; returns true if row r gained a bit
+    bool orRow(int r, const uint64_t *src) {
+        uint64_t *dst = row(r);
+        uint64_t changed = 0;
+        for (int w = 0; w < words; w++) {
+            uint64_t merged = dst[w] | src[w];
+            changed |= merged ^ dst[w];
+            dst[w] = merged;
+        }
+        return changed != 0;
+    }
+};
+
+struct Grammar {
+    vector<string> names;               // id -> symbol name
+    unordered_map<string, int> ids;     // symbol name -> id
+    int numTerminals = 0;   // ids [0, numTerminals) are terminals
+    int epsilon = -1;       // id of "#"
+    int endMarker = -1;     // id of "$"
+    int start = -1;
+
+    // productions in input order; the right-hand side of p is
+    // rhsSymbols[rhsStart[p] .. rhsStart[p + 1]), empty for epsilon
+    vector<int> prodLhs;
+    vector<int> rhsStart = {0};
+    vector<int> rhsSymbols;
+
+    // productions of nonterminal row r are byLhs[lhsStart[r] .. lhsStart[r + 1]),
+    // in input order
+    vector<int> lhsStart;
+    vector<int> byLhs;
+
+    int numSymbols() const { return names.size(); }
+    int numProductions() const { return prodLhs.size(); }
+    const int *rhs(int p) const { return rhsSymbols.data() + rhsStart[p]; }
+    int rhsLength(int p) const { return rhsStart[p + 1] - rhsStart[p]; }
+
+    bool isTerminal(int id) const { return id < numTerminals; }
+    int numNonTerminals() const { return names.size() - numTerminals; }
+    int row(int nonTerminal) const { return nonTerminal - numTerminals; }
+    int nonTerminal(int row) const { return row + numTerminals; }
+
+    // id of a symbol name, -1 if the grammar does not use it
+    int id(const string &name) const {
+        auto it = ids.find(name);
+        return it == ids.end() ? -1 : it->second;
+    }
+};
+
+// Assigns the final symbol ids of a grammar given over provisional ids
+// (names[i], isLhs[i], productions as in Grammar): terminals, with "#" and
+// "$" added, come first, then the symbols marked isLhs, each group in name
+// order. start is a provisional id or -1.
+inline Grammar finishGrammar(const vector<string> &names, const vector<char> &isLhs,
+                             const vector<int> &prodLhs, const vector<int> &rhsStart,
+                             const vector<int> &rhsSymbols, int start) {
+    Grammar g;
+    vector<int> terminals, nonTerminals;
+    for (int i = 0; i < (int)names.size(); i++) {
+        if (names[i] == "#" || names[i] == "$") continue;
+        (isLhs[i] ? nonTerminals : terminals).push_back(i);
+    }
+    auto byName = [&](int a, int b) { return names[a] < names[b]; };
+    sort(terminals.begin(), terminals.end(), byName);
+    sort(nonTerminals.begin(), nonTerminals.end(), byName);
+
+    // merge "#" and "$" into the name order of the other terminals
+    vector<string> fixed = {"#", "$"};
+    vector<int> remap(names.size(), -1);
+    size_t t = 0;
+    auto addTerminal = [&](const string &name, int provisional) {
+        g.ids[name] = g.names.size();
+        if (provisional >= 0) remap[provisional] = g.names.size();
+        g.names.push_back(name);
+    };
+    for (const string &f : fixed) {
+        for (; t < terminals.size() && names[terminals[t]] < f; t++) addTerminal(names[terminals[t]], terminals[t]);
+        addTerminal(f, -1);
+    }
+    for (; t < terminals.size(); t++) addTerminal(names[terminals[t]], terminals[t]);
+    g.numTerminals = g.names.size();
+    for (int i : nonTerminals) addTerminal(names[i], i);
+    for (int i = 0; i < (int)names.size(); i++) {
+        if (remap[i] < 0) remap[i] = g.ids[names[i]];     // "#" or "$" used as a symbol
+    }
+    g.epsilon = g.ids["#"];
+    g.endMarker = g.ids["$"];
+    g.start = start >= 0 ? remap[start] : -1;
+
+    g.prodLhs.resize(prodLhs.size());
+    for (size_t p = 0; p < prodLhs.size(); p++) g.prodLhs[p] = remap[prodLhs[p]];
+    g.rhsStart = rhsStart;
+    g.rhsSymbols.resize(rhsSymbols.size());
+    for (size_t i = 0; i < rhsSymbols.size(); i++) g.rhsSymbols[i] = remap[rhsSymbols[i]];
+
+    // group production numbers by left-hand side (counting sort, stable)
+    g.lhsStart.assign(g.numNonTerminals() + 1, 0);
+    for (int lhs : g.prodLhs) g.lhsStart[g.row(lhs) + 1]++;
+    for (int r = 0; r < g.numNonTerminals(); r++) g.lhsStart[r + 1] += g.lhsStart[r];
+    g.byLhs.resize(g.numProductions());
+    vector<int> fillAt(g.lhsStart.begin(), g.lhsStart.end() - 1);
+    for (int p = 0; p < g.numProductions(); p++) g.byLhs[fillAt[g.row(g.prodLhs[p])]++] = p;
+    return g;
+}
+
+// Collects productions and interns their symbols into a Grammar.
+//
+// Lines have the form "LHS->alt|alt|...". If any line contains whitespace
+// or a left-hand side longer than one character, symbols are separated by
+// whitespace ("expr -> expr + term | term"); otherwise every character is a
+// symbol, as in the original tools ("E->E+T|T"). "#" and "ε" stand for epsilon.
+// Nonterminals are the symbols that appear on a left-hand side.
+class GrammarBuilder {
+    struct Entry {
+        string lhs;
+        vector<string> rhs;
+        bool raw;       // rhs[0] is alternative text still to be split into symbols
+    };
+    vector<Entry> entries;
+    bool spaced = false;
+
+    static string trim(const string &s) {
+        size_t b = s.find_first_not_of(" \t\r\n");
+        if (b == string::npos) return "";
+        size_t e = s.find_last_not_of(" \t\r\n");
+        return s.substr(b, e - b + 1);
+    }
+
+    static bool isEpsilon(const string &s) {
+        return s == "#" || s == "ε";
+    }
+
+    vector<string> split(const string &text) const {
+        vector<string> out;
+        if (spaced) {
+            istringstream in(text);
+            string sym;
+            while (in >> sym) out.push_back(sym);
+        } else {
+            for (size_t i = 0; i < text.size(); i++) {
+                if (text.compare(i, strlen("ε"), "ε") == 0) {
+                    out.push_back("#");
+                    i += strlen("ε") - 1;
+                } else {
+                    out.push_back(string(1, text[i]));
+                }
+            }
+        }
+        return out;
+    }
+
+public:
+    // rhs is a list of symbol names; an empty list (or just "#") is epsilon
+    void addProduction(const string &lhs, const vector<string> &rhs) {
+        entries.push_back({lhs, rhs, false});
+    }
+
+    // Adds every alternative of "LHS->alt|alt"; returns false if there is no "->"
+    bool addLine(const string &line) {
+        size_t arrow = line.find("->");
+        if (arrow == string::npos) return false;
+        string lhs = trim(line.substr(0, arrow));
+        if (lhs.size() > 1 || trim(line).find_first_of(" \t") != string::npos) spaced = true;
+
+        string rhs = line.substr(arrow + 2);
+        size_t from = 0;
+        while (true) {
+            size_t bar = rhs.find('|', from);
+            string alt = rhs.substr(from, bar == string::npos ? string::npos : bar - from);
+            entries.push_back({lhs, {alt}, true});
+            if (bar == string::npos) break;
+            from = bar + 1;
+        }
+        return true;
+    }
+
+    // The productions added so far as (lhs, rhs symbol names); epsilon is an empty rhs
+    vector<pair<string, vector<string>>> productions() const {
+        vector<pair<string, vector<string>>> prods;
+        for (const Entry &e : entries) {
+            vector<string> body = e.raw ? split(spaced ? e.rhs[0] : trim(e.rhs[0])) : e.rhs;
+            body.erase(remove_if(body.begin(), body.end(), isEpsilon), body.end());
+            prods.push_back({e.lhs, body});
+        }
+        return prods;
+    }
+
+    // startSymbol defaults to the left-hand side of the first production
+    Grammar build(const string &startSymbol = "") const {
+        vector<pair<string, vector<string>>> prods = productions();
+
+        // provisional ids in order of appearance
+        unordered_map<string, int> seen;
+        vector<string> names;
+        vector<char> isLhs;
+        auto intern = [&](const string &s) {
+            auto it = seen.find(s);
+            if (it != seen.end()) return it->second;
+            seen[s] = names.size();
+            names.push_back(s);
+            isLhs.push_back(0);
+            return (int)names.size() - 1;
+        };
+        vector<int> prodLhs, rhsStart = {0}, rhsSymbols;
+        for (auto &p : prods) {
+            prodLhs.push_back(intern(p.first));
+            isLhs[prodLhs.back()] = 1;
+            for (const string &sym : p.second) rhsSymbols.push_back(intern(sym));
+            rhsStart.push_back(rhsSymbols.size());
+        }
+        string startName = startSymbol.empty() && !prods.empty() ? prods[0].first : startSymbol;
+        auto it = seen.find(startName);
+        int start = it != seen.end() && isLhs[it->second] ? it->second : -1;
+        return finishGrammar(names, isLhs, prodLhs, rhsStart, rhsSymbols, start);
+    }
+};
+
+// ORs FIRST(begin..end) minus epsilon into out; returns true if that sequence can derive epsilon
+inline bool firstOfSequence(const Grammar &g, const BitMatrix &first, const int *begin, const int *end,
+                            uint64_t *out) {
+    for (const int *s = begin; s != end; s++) {
+        int sym = *s;
+        if (g.isTerminal(sym)) {
+            out[sym >> 6] |= 1ULL << (sym & 63);
+            return false;
+        }
+        const uint64_t *row = first.row(g.row(sym));
+        for (int w = 0; w < first.words; w++) out[w] |= row[w];
+        out[g.epsilon >> 6] &= ~(1ULL << (g.epsilon & 63));
+        if (!first.test(g.row(sym), g.epsilon)) return false;
+    }
+    return true;
+}
+
+// DeRemer-Pennello digraph traversal: on entry sets holds each node's own
+// bits, on exit every row also holds the rows of all nodes reachable
+// through edges. Strongly connected components are found with Tarjan's
+// numbering and share one result, so every edge is followed once.
+inline void digraph(const vector<vector<int>> &edges, BitMatrix &sets) {
+    const int INF = INT_MAX;
+    int n = edges.size();
+    vector<int> depth(n, 0), pushedAt(n, 0), stack;
+    vector<pair<int, size_t>> calls;    // explicit recursion: node, next edge
+
+    for (int root = 0; root < n; root++) {
+        if (depth[root] != 0) continue;
+        calls.push_back({root, 0});
+        stack.push_back(root);
+        depth[root] = pushedAt[root] = stack.size();
+
+        while (!calls.empty()) {
+            int x = calls.back().first;
+            size_t &e = calls.back().second;
+            if (e < edges[x].size()) {
+                int y = edges[x][e++];
+                if (depth[y] == 0) {
+                    stack.push_back(y);
+                    depth[y] = pushedAt[y] = stack.size();
+                    calls.push_back({y, 0});
+                    continue;
+                }
+                depth[x] = min(depth[x], depth[y]);
+                sets.orRow(x, sets.row(y));
+                continue;
+            }
+
+            // x is finished: close its component if it is the root of one
+            if (depth[x] == pushedAt[x]) {
+                while (true) {
+                    int top = stack.back();
+                    stack.pop_back();
+                    depth[top] = INF;
+                    if (top == x) break;
+                    copy(sets.row(x), sets.row(x) + sets.words, sets.row(top));
+                }
+            }
+            calls.pop_back();
+            if (!calls.empty()) {
+                int parent = calls.back().first;
+                depth[parent] = min(depth[parent], depth[x]);
+                sets.orRow(parent, sets.row(x));
+            }
+        }
+    }
+}
+
+// Strongly connected components (Tarjan). Components are numbered in the
+// order they are closed, so every edge leaving a component points to one
+// with a smaller number. Returns the number of components.
+inline int condense(const vector<vector<int>> &edges, vector<int> &comp) {
+    const int INF = INT_MAX;
+    int n = edges.size(), count = 0;
+    vector<int> depth(n, 0), pushedAt(n, 0), stack;
+    vector<pair<int, size_t>> calls;
+    comp.assign(n, -1);
+
+    for (int root = 0; root < n; root++) {
+        if (depth[root] != 0) continue;
+        calls.push_back({root, 0});
+        stack.push_back(root);
+        depth[root] = pushedAt[root] = stack.size();
+
+        while (!calls.empty()) {
+            int x = calls.back().first;
+            size_t &e = calls.back().second;
+            if (e < edges[x].size()) {
+                int y = edges[x][e++];
+                if (depth[y] == 0) {
+                    stack.push_back(y);
+                    depth[y] = pushedAt[y] = stack.size();
+                    calls.push_back({y, 0});
+                    continue;
+                }
+                depth[x] = min(depth[x], depth[y]);
+                continue;
+            }
+
+            if (depth[x] == pushedAt[x]) {
+                while (true) {
+                    int top = stack.back();
+                    stack.pop_back();
+                    depth[top] = INF;
+                    comp[top] = count;
+                    if (top == x) break;
+                }
+                count++;
+            }
+            calls.pop_back();
+            if (!calls.empty()) {
+                int parent = calls.back().first;
+                depth[parent] = min(depth[parent], depth[x]);
+            }
+        }
+    }
+    return count;
+}
+
+// Same result as digraph(), computed on several threads. The graph is
+// condensed into components, and each component gets a level one above the
+// highest level it has an edge to. Components of one level only read rows
+// of lower levels, so a level is split across a small thread pool and the
+// threads meet at a barrier before the next level. Set union does not
+// depend on order, so the rows are bit-identical to digraph()'s.
+inline void digraphParallel(const vector<vector<int>> &edges, BitMatrix &sets, int threads) {
+    if (threads <= 1) {
+        digraph(edges, sets);
+        return;
+    }
+    int n = edges.size();
+    vector<int> comp;
+    int numComps = condense(edges, comp);
+
+    // nodes grouped by component
+    vector<int> compStart(numComps + 1, 0), members(n);
+    for (int x = 0; x < n; x++) compStart[comp[x] + 1]++;
+    for (int c = 0; c < numComps; c++) compStart[c + 1] += compStart[c];
+    vector<int> fillAt(compStart.begin(), compStart.end() - 1);
+    for (int x = 0; x < n; x++) members[fillAt[comp[x]]++] = x;
+
+    // levels: successors always have smaller component numbers, so one pass in order is enough
+    vector<int> level(numComps, 0);
+    vector<long long> weight(numComps, 0);  // rows ORed while solving the component
+    int numLevels = 0;
+    for (int c = 0; c < numComps; c++) {
+        for (int k = compStart[c]; k < compStart[c + 1]; k++) {
+            weight[c] += 2 + edges[members[k]].size();
+            for (int y : edges[members[k]]) {
+                if (comp[y] != c) level[c] = max(level[c], level[comp[y]] + 1);
+            }
+        }
+        numLevels = max(numLevels, level[c] + 1);
+    }
+    vector<int> levelStart(numLevels + 1, 0), byLevel(numComps);
+    for (int c = 0; c < numComps; c++) levelStart[level[c] + 1]++;
+    for (int l = 0; l < numLevels; l++) levelStart[l + 1] += levelStart[l];
+    fillAt.assign(levelStart.begin(), levelStart.end() - 1);
+    for (int c = 0; c < numComps; c++) byLevel[fillAt[level[c]]++] = c;
+
+    // a component's row is the union of its members' rows and of the rows it has edges to
+    auto solve = [&](int c) {
+        int rep = members[compStart[c]];
+        for (int k = compStart[c]; k < compStart[c + 1]; k++) {
+            int x = members[k];
+            if (x != rep) sets.orRow(rep, sets.row(x));
+            for (int y : edges[x]) {
+                if (comp[y] != c) sets.orRow(rep, sets.row(y));
+            }
+        }
+        for (int k = compStart[c] + 1; k < compStart[c + 1]; k++) {
+            copy(sets.row(rep), sets.row(rep) + sets.words, sets.row(members[k]));
+        }
+    };
+
+    mutex lock;
+    condition_variable wake, finished;
+    int generation = 0, busy = 0, end = 0;
+    bool stop = false;
+    atomic<int> next(0);
+    auto work = [&]() {
+        for (int i; (i = next.fetch_add(1)) < end; ) solve(byLevel[i]);
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.emplace_back([&]() {
+            int seen = 0;
+            unique_lock<mutex> guard(lock);
+            while (true) {
+                wake.wait(guard, [&]() { return stop || generation != seen; });
+                if (stop) return;
+                seen = generation;
+                guard.unlock();
+                work();
+                guard.lock();
+                if (--busy == 0) finished.notify_one();
+            }
+        });
+    }
+
+    // small levels are not worth waking the pool for
+    const long long PARALLEL_WEIGHT = 4096;
+    for (int l = 0; l < numLevels; l++) {
+        long long levelWeight = 0;
+        for (int i = levelStart[l]; i < levelStart[l + 1]; i++) levelWeight += weight[byLevel[i]];
+        if (levelWeight * sets.words < PARALLEL_WEIGHT || levelStart[l + 1] - levelStart[l] == 1) {
+            for (int i = levelStart[l]; i < levelStart[l + 1]; i++) solve(byLevel[i]);
+            continue;
+        }
+        {
+            lock_guard<mutex> guard(lock);
+            next = levelStart[l];
+            end = levelStart[l + 1];
+            busy = threads - 1;
+            generation++;
+        }
+        wake.notify_all();
+        work();
+        unique_lock<mutex> guard(lock);
+        finished.wait(guard, [&]() { return busy == 0; });
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        stop = true;
+    }
+    wake.notify_all();
+    for (thread &t : pool) t.join();
+}
+
+// Nullable nonterminals by counting: a production fires once all of its
+// symbols are known to be nullable
+inline vector<bool> computeNullable(const Grammar &g) {
+    int n = g.numNonTerminals();
+    vector<bool> nullable(n, false);
+    vector<int> remaining(g.numProductions());
+    vector<vector<int>> usedIn(n);     // productions waiting on each nonterminal
+    vector<int> work;
+
+    for (int p = 0; p < g.numProductions(); p++) {
+        const int *rhs = g.rhs(p), *end = rhs + g.rhsLength(p);
+        if (any_of(rhs, end, [&](int sym) { return g.isTerminal(sym); })) {
+            remaining[p] = -1;
+            continue;
+        }
+        remaining[p] = g.rhsLength(p);
+        for (const int *s = rhs; s != end; s++) usedIn[g.row(*s)].push_back(p);
+        if (remaining[p] == 0 && !nullable[g.row(g.prodLhs[p])]) {
+            nullable[g.row(g.prodLhs[p])] = true;
+            work.push_back(g.row(g.prodLhs[p]));
+        }
+    }
+    while (!work.empty()) {
+        int a = work.back();
+        work.pop_back();
+        for (int p : usedIn[a]) {
+            if (--remaining[p] == 0 && !nullable[g.row(g.prodLhs[p])]) {
+                nullable[g.row(g.prodLhs[p])] = true;
+                work.push_back(g.row(g.prodLhs[p]));
+            }
+        }
+    }
+    return nullable;
+}
+
+// FIRST sets, one row per nonterminal; the epsilon column marks nullable nonterminals.
+// FIRST(A) includes FIRST(B) whenever A -> alpha B ... with alpha nullable;
+// those inclusions form a graph that digraph() solves in one pass
+// (digraphParallel() when threads > 1).
+inline BitMatrix computeFirst(const Grammar &g, int threads = 1) {
+    BitMatrix first(g.numNonTerminals(), g.numTerminals);
+    vector<bool> nullable = computeNullable(g);
+    vector<vector<int>> includes(g.numNonTerminals());
+
+    for (int p = 0; p < g.numProductions(); p++) {
+        int a = g.row(g.prodLhs[p]);
+        for (const int *s = g.rhs(p); s != g.rhs(p) + g.rhsLength(p); s++) {
+            int sym = *s;
+            if (g.isTerminal(sym)) {
+                first.set(a, sym);
+                break;
+            }
+            includes[a].push_back(g.row(sym));
+            if (!nullable[g.row(sym)]) break;
+        }
+    }
+
+    digraphParallel(includes, first, threads);
+    for (int a = 0; a < g.numNonTerminals(); a++) {
+        if (nullable[a]) first.set(a, g.epsilon);
+    }
+    return first;
+}
+
+// FIRST of every production suffix, computed once from the FIRST sets.
+// Row at(p, i) is FIRST(rhs(p)[i..]) with the epsilon column set when the
+// suffix can derive epsilon; at(p, rhsLength(p)) is the empty suffix {#}.
+// An LR(1) closure step needs FIRST(beta a) = at(p, dot + 1) minus epsilon,
+// plus a if the epsilon column is set.
+struct SuffixFirst {
+    BitMatrix sets;
+    vector<int> base;       // row of the full right-hand side of each production
+    int epsilon = -1;       // column of "#"
+
+    int at(int p, int i) const { return base[p] + i; }
+    const uint64_t *row(int p, int i) const { return sets.row(base[p] + i); }
+    bool nullable(int p, int i) const { return sets.test(base[p] + i, epsilon); }
+};
+
+inline SuffixFirst computeSuffixFirst(const Grammar &g, const BitMatrix &first) {
+    SuffixFirst suffix;
+    suffix.epsilon = g.epsilon;
+    suffix.base.resize(g.numProductions());
+    int rows = 0;
+    for (int p = 0; p < g.numProductions(); p++) {
+        suffix.base[p] = rows;
+        rows += g.rhsLength(p) + 1;
+    }
+    suffix.sets = BitMatrix(rows, g.numTerminals);
+
+    // right to left: each suffix is its first symbol plus, if that is nullable, the next suffix
+    for (int p = 0; p < g.numProductions(); p++) {
+        int n = g.rhsLength(p);
+        suffix.sets.set(suffix.at(p, n), g.epsilon);
+        for (int i = n - 1; i >= 0; i--) {
+            int sym = g.rhs(p)[i], r = suffix.at(p, i);
+            if (g.isTerminal(sym)) {
+                suffix.sets.set(r, sym);
+                continue;
+            }
+            suffix.sets.orRow(r, first.row(g.row(sym)));
+            suffix.sets.row(r)[g.epsilon >> 6] &= ~(1ULL << (g.epsilon & 63));
+            if (first.test(g.row(sym), g.epsilon)) suffix.sets.orRow(r, suffix.sets.row(r + 1));
+        }
+    }
+    return suffix;
+}
+
+// FOLLOW sets, one row per nonterminal; '$' is added to FOLLOW(start).
+// For A -> alpha B beta, FIRST(beta) goes into FOLLOW(B) directly and,
+// if beta is nullable, FOLLOW(B) includes FOLLOW(A). threads as for computeFirst.
+inline BitMatrix computeFollow(const Grammar &g, const BitMatrix &first, int threads = 1) {
+    BitMatrix follow(g.numNonTerminals(), g.numTerminals);
+    if (g.start >= 0) follow.set(g.row(g.start), g.endMarker);
+    vector<vector<int>> includes(g.numNonTerminals());
+    vector<uint64_t> rest(follow.words);    // FIRST of the suffix after the current symbol
+
+    for (int p = 0; p < g.numProductions(); p++) {
+        const int *rhs = g.rhs(p);
+        int a = g.row(g.prodLhs[p]);
+        fill(rest.begin(), rest.end(), 0);
+        bool restNullable = true;
+
+        // one right-to-left sweep per production
+        for (int i = g.rhsLength(p) - 1; i >= 0; i--) {
+            int sym = rhs[i];
+            if (g.isTerminal(sym)) {
+                fill(rest.begin(), rest.end(), 0);
+                rest[sym >> 6] |= 1ULL << (sym & 63);
+                restNullable = false;
+                continue;
+            }
+            int b = g.row(sym);
+            follow.orRow(b, rest.data());
+            if (restNullable && b != a) includes[b].push_back(a);
+
+            const uint64_t *symFirst = first.row(b);
+            if (first.test(b, g.epsilon)) {
+                for (int w = 0; w < follow.words; w++) rest[w] |= symFirst[w];
+            } else {
+                copy(symFirst, symFirst + follow.words, rest.begin());
+                restNullable = false;
+            }
+            rest[g.epsilon >> 6] &= ~(1ULL << (g.epsilon & 63));
+        }
+    }
+
+    digraphParallel(includes, follow, threads);
+    return follow;
+}
+
+// Terminal names of a set row, in id (= name) order
+inline vector<string> setSymbols(const Grammar &g, const BitMatrix &sets, int nonTerminal) {
+    vector<string> out;
+    for (int t = 0; t < g.numTerminals; t++) {
+        if (sets.test(g.row(nonTerminal), t)) out.push_back(g.names[t]);
+    }
+    return out;
+}
+
+// "A -> x y", or "A -> #" for an epsilon production
+inline string productionString(const Grammar &g, int p) {
+    string s = g.names[g.prodLhs[p]] + " ->";
+    for (int i = 0; i < g.rhsLength(p); i++) s += " " + g.names[g.rhs(p)[i]];
+    if (g.rhsLength(p) == 0) s += " #";
+    return s;
+}
+
+// LR item "A -> x . y"
+inline string itemString(const Grammar &g, int p, int dot) {
+    string s = g.names[g.prodLhs[p]] + " ->";
+    for (int i = 0; i < g.rhsLength(p); i++) {
+        if (i == dot) s += " .";
+        s += " " + g.names[g.rhs(p)[i]];
+    }
+    if (dot == g.rhsLength(p)) s += " .";
+    return s;
+}
@@ -0,0 +1,340 @@
+#include <bits/stdc++.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace std;
+
+// Grammar analysis benchmark
+//
+// Generates synthetic grammars and times the grammar tools on them:
+//   FIRST, FOLLOW, LL1, LR0, SLR, LALR, CLR  --grammar <file> --stats
+// Each tool prints one "stats name=value ..." line with its phase timings
+// (first_ms, follow_ms, ll1_table_ms, slr_automaton_ms, ...) and sizes
+// (states, items, ...); the benchmark adds wall time and peak RSS.
+//
+// Build the tools in the current directory first, then run
+//   GrammarBench [--sizes 25,100,400] [--terminals T] [--alternatives A]
+//                [--nullable D] [--max-rhs L]
+//                [--shape random|acyclic|left|right|expr|all] [--seed S]
+//                [--tools FIRST,FOLLOW,...] [--repeat N] [--timeout SEC]
+//                [--json] [--bin-dir DIR]
+// Sizes are nonterminal counts; T defaults to half of each size. A tool
+// still running after --timeout seconds (default 10) is killed and reported.
+// --emit FILE writes one grammar (of the first size and shape) and exits.
+// Results are written to stdout as CSV (default) or JSON, one record per
+// grammar, tool and metric.
+
+struct Shape {
+    int nonTerminals = 100;
+    int terminals = 0;          // 0: nonTerminals / 2
+    int alternatives = 3;       // average productions per nonterminal
+    double nullable = 0.1;      // fraction of nonterminals with an epsilon production
+    int maxRhs = 4;
+    string recursion = "random";
+};
+
+const vector<string> recursions = {"random", "acyclic", "left", "right", "expr"};
+
+// A grammar in the GrammarFile.h format. Every nonterminal is reachable
+// from N0 and can derive a terminal string: each one has a production that
+// only refers to higher-numbered nonterminals, and is used by a lower one.
+//   random   other references go to any nonterminal
+//   acyclic  only to higher-numbered nonterminals, so nothing is recursive
+//   left     as acyclic, plus A -> A t ... for every A
+//   right    as acyclic, plus A -> t ... A for every A
+//   expr     a precedence ladder N_i -> N_i t N_i+1 | N_i+1, closed by
+//            parentheses (alternatives and max-rhs are ignored)
+string generateGrammar(const Shape &shape, unsigned seed, int &productions) {
+    mt19937 rng(seed);
+    int n = max(1, shape.nonTerminals);
+    int t = shape.terminals > 0 ? shape.terminals : max(4, n / 2);
+    auto nt = [](int i) { return "N" + to_string(i); };
+    auto term = [](int i) { return "t" + to_string(i); };
+    auto coin = [&](double p) { return uniform_real_distribution<double>(0, 1)(rng) < p; };
+    vector<vector<vector<string>>> alts(n);
+
+    if (shape.recursion == "expr") {
+        for (int i = 0; i + 1 < n; i++) {
+            alts[i].push_back({nt(i), term(2 + i % (t - 2)), nt(i + 1)});
+            alts[i].push_back({nt(i + 1)});
+        }
+        alts[n - 1].push_back({term(0), nt(0), term(1)});
+        alts[n - 1].push_back({term(2 + (n - 1) % (t - 2))});
+    } else {
+        bool anyTarget = shape.recursion == "random";
+        auto body = [&](int lhs, bool anchor) {
+            vector<string> rhs;
+            int len = 1 + rng() % max(1, shape.maxRhs);
+            for (int k = 0; k < len; k++) {
+                bool later = lhs + 1 < n;
+                if (coin(0.5) || (!anyTarget && !later) || (anchor && !later)) {
+                    rhs.push_back(term(rng() % t));
+                } else if (anyTarget && !anchor) {
+                    rhs.push_back(nt(rng() % n));
+                } else {
+                    rhs.push_back(nt(lhs + 1 + rng() % (n - lhs - 1)));
+                }
+            }
+            return rhs;
+        };
+        for (int i = 0; i < n; i++) alts[i].push_back(body(i, true));
+        for (int i = 1; i < n; i++) {
+            // reachability: a lower nonterminal uses N_i
+            int parent = rng() % i;
+            auto &rhs = alts[parent][rng() % alts[parent].size()];
+            rhs.insert(rhs.begin() + rng() % (rhs.size() + 1), nt(i));
+        }
+        long long extra = (long long)n * max(0, shape.alternatives - 1);
+        for (long long k = 0; k < extra; k++) {
+            int lhs = rng() % n;
+            alts[lhs].push_back(body(lhs, false));
+        }
+        for (int i = 0; i < n; i++) {
+            if (shape.recursion == "left") {
+                vector<string> rhs = {nt(i), term(rng() % t)};
+                alts[i].push_back(rhs);
+            } else if (shape.recursion == "right") {
+                vector<string> rhs = {term(rng() % t), nt(i)};
+                alts[i].push_back(rhs);
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        if (coin(shape.nullable)) alts[i].push_back({});
+    }
+
+    string out;
+    productions = 0;
+    for (int i = 0; i < n; i++) {
+        out += nt(i) + " ->";
+        for (size_t a = 0; a < alts[i].size(); a++) {
+            if (a > 0) out += " |";
+            if (alts[i][a].empty()) out += " %empty";
+            for (const string &s : alts[i][a]) out += " " + s;
+            productions++;
+        }
+        out += " ;\n";
+    }
+    return out;
+}
+
+bool writeFile(const string &path, const string &data) {
+    ofstream out(path, ios::binary);
+    out.write(data.data(), data.size());
+    return (bool)out;
+}
+
+bool fileExists(const string &path) {
+    return ifstream(path).good();
+}
+
+struct Run {
+    bool ok = false;
+    bool timedOut = false;
+    double seconds = 0;
+    long peakKB = 0;
+    string output;
+};
+
+// Runs argv with stdout captured; kills it after timeout seconds
+Run runTool(const vector<string> &args, double timeout) {
+    Run run;
+    int out[2];
+    if (pipe(out) != 0) return run;
+    auto start = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) return run;
+    if (pid == 0) {
+        dup2(out[1], 1);
+        close(out[0]);
+        close(out[1]);
+        vector<char *> argv;
+        for (const string &a : args) argv.push_back((char *)a.c_str());
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    close(out[1]);
+
+    char buf[4096];
+    while (true) {
+        double left = timeout - chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (left <= 0) {
+            kill(pid, SIGKILL);
+            run.timedOut = true;
+            break;
+        }
+        pollfd p = {out[0], POLLIN, 0};
+        if (poll(&p, 1, (int)min(left * 1000 + 1, 1000.0)) <= 0) continue;
+        ssize_t got = read(out[0], buf, sizeof buf);
+        if (got <= 0) break;
+        run.output.append(buf, got);
+    }
+    close(out[0]);
+
+    int status = 0;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    run.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    run.peakKB = usage.ru_maxrss;
+    run.ok = !run.timedOut && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return run;
+}
+
+// The name=value pairs of a "stats ..." line
+vector<pair<string, string>> parseStats(const string &output) {
+    vector<pair<string, string>> values;
+    size_t at = output.rfind("stats ");
+    if (at == string::npos) return values;
+    istringstream in(output.substr(at + 6, output.find('\n', at) - at - 6));
+    string word;
+    while (in >> word) {
+        size_t eq = word.find('=');
+        if (eq != string::npos) values.push_back({word.substr(0, eq), word.substr(eq + 1)});
+    }
+    return values;
+}
+
+vector<string> splitList(const string &s) {
+    vector<string> out;
+    stringstream in(s);
+    string item;
+    while (getline(in, item, ',')) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+struct Result {
+    string shape;
+    int size;
+    string tool, metric, value;
+};
+
+int main(int argc, char *argv[]) {
+    Shape base;
+    vector<int> sizes = {25, 100, 400};
+    string shapeName = "all";
+    vector<string> tools = {"FIRST", "FOLLOW", "LL1", "LR0", "SLR", "LALR", "CLR"};
+    unsigned seed = 12345;
+    int repeat = 1;
+    double timeout = 10;
+    bool json = false;
+    string binDir = ".";
+    string emitPath;
+
+    for (int a = 1; a < argc; a++) {
+        string arg = argv[a];
+        auto value = [&]() { return a + 1 < argc ? string(argv[++a]) : string(); };
+        if (arg == "--sizes") {
+            sizes.clear();
+            for (const string &s : splitList(value())) sizes.push_back(max(1, atoi(s.c_str())));
+        }
+        else if (arg == "--terminals") base.terminals = max(4, atoi(value().c_str()));
+        else if (arg == "--alternatives") base.alternatives = max(1, atoi(value().c_str()));
+        else if (arg == "--nullable") base.nullable = atof(value().c_str());
+        else if (arg == "--max-rhs") base.maxRhs = max(1, atoi(value().c_str()));
+        else if (arg == "--shape") shapeName = value();
+        else if (arg == "--seed") seed = strtoul(value().c_str(), nullptr, 10);
+        else if (arg == "--tools") tools = splitList(value());
+        else if (arg == "--repeat") repeat = max(1, atoi(value().c_str()));
+        else if (arg == "--timeout") timeout = atof(value().c_str());
+        else if (arg == "--json") json = true;
+        else if (arg == "--bin-dir") binDir = value();
+        else if (arg == "--emit") emitPath = value();
+        else {
+            cerr << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+    if (sizes.empty()) sizes = {base.nonTerminals};
+
+    vector<string> shapes;
+    for (const string &r : recursions) {
+        if (shapeName == "all" || shapeName == r) shapes.push_back(r);
+    }
+    if (shapes.empty()) {
+        cerr << "Unknown shape " << shapeName << endl;
+        return 1;
+    }
+
+    if (!emitPath.empty()) {
+        Shape shape = base;
+        shape.nonTerminals = sizes[0];
+        shape.recursion = shapes[0];
+        int productions;
+        return writeFile(emitPath, generateGrammar(shape, seed, productions)) ? 0 : 1;
+    }
+
+    string dir = "/tmp";
+    if (const char *tmp = getenv("TMPDIR")) dir = tmp;
+
+    vector<string> available;
+    for (const string &tool : tools) {
+        if (fileExists(binDir + "/" + tool)) available.push_back(tool);
+        else cerr << "Skipping " << tool << ": " << binDir + "/" + tool << " not found\n";
+    }
+
+    vector<Result> results;
+    for (const string &recursion : shapes) {
+        for (int size : sizes) {
+            Shape shape = base;
+            shape.nonTerminals = size;
+            shape.recursion = recursion;
+            int productions;
+            string path = dir + "/bench_grammar_" + recursion + "_" + to_string(size) + ".g";
+            writeFile(path, generateGrammar(shape, seed, productions));
+
+            for (const string &tool : available) {
+                // best of N runs by wall time; a timeout is not retried
+                Run best;
+                for (int r = 0; r < repeat; r++) {
+                    Run run = runTool({binDir + "/" + tool, "--grammar", path, "--stats"}, timeout);
+                    if (run.ok && (!best.ok || run.seconds < best.seconds)) best = run;
+                    if (run.timedOut) {
+                        best = run;
+                        break;
+                    }
+                }
+                auto add = [&](const string &metric, const string &value) {
+                    results.push_back({recursion, size, tool, metric, value});
+                };
+                if (!best.ok) {
+                    cerr << tool << (best.timedOut ? " timed out" : " failed") << " on "
+                         << recursion << " " << size << "\n";
+                    add("status", best.timedOut ? "timeout" : "failed");
+                    continue;
+                }
+                add("status", "ok");
+                add("wall_ms", to_string(best.seconds * 1000));
+                add("peak_rss_kb", to_string(best.peakKB));
+                for (auto &v : parseStats(best.output)) add(v.first, v.second);
+            }
+            remove(path.c_str());
+        }
+    }
+
+    auto numeric = [](const string &v) {
+        return !v.empty() && v.find_first_not_of("0123456789.-") == string::npos;
+    };
+    if (json) {
+        cout << "[\n";
+        for (int i = 0; i < results.size(); i++) {
+            const Result &r = results[i];
+            cout << "  {\"shape\": \"" << r.shape << "\", \"size\": " << r.size
+                 << ", \"tool\": \"" << r.tool << "\", \"metric\": \"" << r.metric << "\", \"value\": "
+                 << (numeric(r.value) ? r.value : "\"" + r.value + "\"") << "}"
+                 << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        cout << "]\n";
+    } else {
+        cout << "shape,size,tool,metric,value\n";
+        for (const Result &r : results) {
+            cout << r.shape << "," << r.size << "," << r.tool << "," << r.metric << "," << r.value << "\n";
+        }
+    }
+
+    return 0;
+}
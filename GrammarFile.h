@@ -0,0 +1,340 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Grammar.h"
+
+// Grammar files, loaded in one pass straight into a Grammar
+// (--grammar file in FIRST, FOLLOW, LL1 and the LR tools).
+//
+//     // expression grammar
+//     %start expr
+//     expr : expr '+' term | term ;
+//     term -> term "*" factor
+//           | factor
+//     factor ::= '(' expr ')' | id
+//     opt -> %empty | ',' expr
+//
+// A rule is a left-hand side, an arrow ("->", ":" or "::="), and
+// alternatives separated by "|". The closing ";" is optional: a symbol
+// followed by an arrow starts the next rule. Symbols are separated by
+// whitespace. A quote at the start of a symbol only delimits the name, so
+// '+' is the symbol +; quoting is needed for names containing | ; : or an
+// arrow, or starting with a quote (E' is a plain name). An empty alternative,
+// "#", "ε" or %empty is epsilon. A quoted '#' and $ (quoted or not) are
+// rejected, since every tool uses those names for epsilon and the end
+// marker. Comments are // to end of line and /* */.
+// %start names the start symbol (default: the first left-hand side); other
+// %directives are skipped to the end of the line, and %% is ignored.
+// As everywhere else, nonterminals are the symbols with a rule.
+class GrammarFileParser {
+    enum Kind { SYMBOL, EPSILON, ARROW, BAR, SEMI, START, END };
+    struct Token {
+        Kind kind;
+        const char *at;
+        string_view text;   // name of a SYMBOL
+    };
+
+    const char *begin, *pos, *end;
+    Token ahead;
+    bool haveAhead = false;
+    string error;
+
+    unordered_map<string_view, int> seen;
+    vector<string> names;
+    vector<char> isLhs;
+    vector<int> prodLhs, rhsStart = {0}, rhsSymbols;
+    int start = -1;
+    string_view startName;
+    const char *startAt = nullptr;
+    string augmentedName;   // owns the text seen keys the augmented start by
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v'; }
+
+    bool fail(const char *at, const string &message) {
+        if (!error.empty()) return false;
+        size_t line = 1 + count(begin, at, '\n');
+        const char *lineStart = at;
+        while (lineStart > begin && lineStart[-1] != '\n') lineStart--;
+        error = to_string(line) + ":" + to_string(at - lineStart + 1) + ": " + message;
+        return false;
+    }
+
+    bool startsWith(const char *p, const char *text) const {
+        size_t n = strlen(text);
+        return (size_t)(end - p) >= n && memcmp(p, text, n) == 0;
+    }
+
+    // Length of an arrow at p, 0 if there is none
+    size_t arrowAt(const char *p) const {
+        if (startsWith(p, "::=")) return 3;
+        if (startsWith(p, "->")) return 2;
+        if (p < end && *p == ':') return 1;
+        return 0;
+    }
+
+    void skipBlank() {
+        while (pos < end) {
+            if (isSpace(*pos)) {
+                pos++;
+            } else if (startsWith(pos, "//")) {
+                const char *nl = (const char *)memchr(pos, '\n', end - pos);
+                pos = nl ? nl : end;
+            } else if (startsWith(pos, "/*")) {
+                const char *p = pos + 2;
+                while (p < end && !startsWith(p, "*/")) p++;
+                pos = p < end ? p + 2 : end;
+            } else {
+                return;
+            }
+        }
+    }
+
+    bool scan(Token &t) {
+        skipBlank();
+        t.at = pos;
+        t.text = string_view();
+        if (pos == end) {
+            t.kind = END;
+            return true;
+        }
+        char c = *pos;
+        if (size_t n = arrowAt(pos)) {
+            pos += n;
+            t.kind = ARROW;
+        } else if (c == '|') {
+            pos++;
+            t.kind = BAR;
+        } else if (c == ';') {
+            pos++;
+            t.kind = SEMI;
+        } else if (c == '\'' || c == '"') {
+            const char *close = (const char *)memchr(pos + 1, c, end - pos - 1);
+            if (!close || memchr(pos + 1, '\n', close - pos - 1)) return fail(pos, "unterminated quoted symbol");
+            if (close == pos + 1) return fail(pos, "empty quoted symbol");
+            t.kind = SYMBOL;
+            t.text = string_view(pos + 1, close - pos - 1);
+            if (!reserved(pos, t.text)) return false;
+            pos = close + 1;
+        } else if (c == '%') {
+            const char *p = pos + 1;
+            while (p < end && !isSpace(*p) && *p != '|' && *p != ';') p++;
+            string_view word(pos, p - pos);
+            pos = p;
+            if (word == "%empty") {
+                t.kind = EPSILON;
+            } else if (word == "%start") {
+                t.kind = START;
+            } else {
+                // %% or a directive this format does not use
+                if (word != "%%") {
+                    const char *nl = (const char *)memchr(pos, '\n', end - pos);
+                    pos = nl ? nl : end;
+                }
+                return scan(t);
+            }
+        } else {
+            const char *p = pos;
+            while (p < end && !isSpace(*p) && *p != '|' && *p != ';' && !arrowAt(p)) p++;
+            t.text = string_view(pos, p - pos);
+            t.kind = t.text == "#" || t.text == "ε" ? EPSILON : SYMBOL;
+            if (t.kind == SYMBOL && !reserved(pos, t.text)) return false;
+            pos = p;
+        }
+        return true;
+    }
+
+    // "#" and "$" name epsilon and the end marker in every tool, so they cannot be terminals
+    bool reserved(const char *at, string_view name) {
+        if (name == "#") return fail(at, "'#' is reserved for epsilon; write %empty or an empty alternative");
+        if (name == "$") return fail(at, "'$' is reserved for the end marker");
+        return true;
+    }
+
+    bool next(Token &t) {
+        if (haveAhead) {
+            haveAhead = false;
+            t = ahead;
+            return true;
+        }
+        return scan(t);
+    }
+
+    bool peek(Token &t) {
+        if (!haveAhead) {
+            if (!scan(ahead)) return false;
+            haveAhead = true;
+        }
+        t = ahead;
+        return true;
+    }
+
+    int intern(string_view name) {
+        auto it = seen.find(name);
+        if (it != seen.end()) return it->second;
+        int id = names.size();
+        seen.emplace(name, id);
+        names.emplace_back(name);
+        isLhs.push_back(0);
+        return id;
+    }
+
+    void endProduction(int lhs) {
+        prodLhs.push_back(lhs);
+        rhsStart.push_back(rhsSymbols.size());
+    }
+
+    // A rule whose left-hand side is name; the arrow is the lookahead
+    bool rule(const Token &name) {
+        Token t;
+        int lhs = -1;
+        auto open = [&](string_view text) {
+            lhs = intern(text);
+            isLhs[lhs] = 1;
+            if (start < 0) start = lhs;
+            next(t);    // the arrow
+        };
+        open(name.text);
+
+        while (true) {
+            if (!next(t)) return false;
+            switch (t.kind) {
+            case SYMBOL: {
+                Token after;
+                if (!peek(after)) return false;
+                if (after.kind == ARROW) {
+                    // t starts the next rule
+                    endProduction(lhs);
+                    open(t.text);
+                    break;
+                }
+                rhsSymbols.push_back(intern(t.text));
+                break;
+            }
+            case EPSILON:
+                break;
+            case BAR:
+                endProduction(lhs);
+                break;
+            case SEMI:
+            case END:
+            case START:
+                endProduction(lhs);
+                ahead = t;
+                haveAhead = true;
+                return true;
+            case ARROW:
+                return fail(t.at, "arrow without a left-hand side");
+            }
+        }
+    }
+
+public:
+    // Parses size bytes at data; on failure returns false with error set to "line:column: message"
+    bool parse(const char *data, size_t size, Grammar &g, string &message, bool augment) {
+        begin = pos = data;
+        end = data + size;
+        seen.reserve(size / 16);
+        rhsSymbols.reserve(size / 4);
+
+        Token t;
+        while (next(t) && t.kind != END) {
+            if (t.kind == SEMI) continue;
+            if (t.kind == START) {
+                if (!next(t)) break;
+                if (t.kind != SYMBOL) {
+                    fail(t.at, "expected a symbol after %start");
+                    break;
+                }
+                startName = t.text;
+                startAt = t.at;
+                continue;
+            }
+            if (t.kind != SYMBOL) {
+                fail(t.at, "expected the left-hand side of a rule");
+                break;
+            }
+            Token arrow;
+            if (!peek(arrow)) break;
+            if (arrow.kind != ARROW) {
+                fail(arrow.at, "expected ->, : or ::= after " + string(t.text));
+                break;
+            }
+            if (!rule(t)) break;
+        }
+        if (error.empty() && prodLhs.empty()) fail(pos, "no rules");
+        if (error.empty() && startAt) {
+            auto it = seen.find(startName);
+            if (it == seen.end() || !isLhs[it->second]) fail(startAt, "start symbol " + string(startName) + " has no rule");
+            else start = it->second;
+        }
+        if (!error.empty()) {
+            message = error;
+            return false;
+        }
+
+        if (augment) {
+            // production 0 is S' -> S, with primes added until the name is new (E' is often taken)
+            augmentedName = names[start] + "'";
+            while (seen.count(augmentedName)) augmentedName += "'";
+            int augmented = intern(augmentedName);
+            isLhs[augmented] = 1;
+            prodLhs.insert(prodLhs.begin(), augmented);
+            rhsSymbols.insert(rhsSymbols.begin(), start);
+            for (int &s : rhsStart) s++;
+            rhsStart.insert(rhsStart.begin(), 0);
+            start = augmented;
+        }
+        g = finishGrammar(names, isLhs, prodLhs, rhsStart, rhsSymbols, start);
+        return true;
+    }
+};
+
+// Loads a grammar file ("-" for stdin) into g. With augment, production 0
+// is S' -> S for the LR tools. On failure returns false with error set to
+// "path:line:column: message".
+inline bool loadGrammarFile(const char *path, Grammar &g, string &error, bool augment = false) {
+    bool standardInput = string(path) == "-";
+    int fd = standardInput ? 0 : open(path, O_RDONLY);
+    if (fd < 0) {
+        error = string(path) + ": " + strerror(errno);
+        return false;
+    }
+
+    const char *data = nullptr;
+    size_t size = 0;
+    string buffer;
+    bool mapped = false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            data = (const char *)p;
+            size = st.st_size;
+            mapped = true;
+        }
+    }
+    if (!mapped) {
+        // pipes and empty files
+        const size_t BLOCK = 1 << 20;
+        ssize_t got;
+        do {
+            size_t used = buffer.size();
+            buffer.resize(used + BLOCK);
+            got = read(fd, &buffer[used], BLOCK);
+            buffer.resize(used + (got > 0 ? got : 0));
+        } while (got > 0);
+        data = buffer.data();
+        size = buffer.size();
+    }
+    if (!standardInput) close(fd);
+
+    GrammarFileParser parser;
+    bool ok = parser.parse(data, size, g, error, augment);
+    if (!ok) error = string(path) + ":" + error;
+    if (mapped) munmap((void *)data, size);
+    return ok;
+}
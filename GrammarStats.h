@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Grammar.h"
+
+// Phase timings and sizes for the grammar tools' --stats mode. print()
+// writes one line, "stats name=value ...", which GrammarBench collects.
+class PhaseStats {
+    chrono::steady_clock::time_point began = chrono::steady_clock::now();
+    vector<pair<string, string>> values;
+
+public:
+    // Starts timing the next phase
+    void start() { began = chrono::steady_clock::now(); }
+
+    // Records the time since start() (or the previous stop()) as phase_ms
+    void stop(const string &phase) {
+        auto now = chrono::steady_clock::now();
+        add(phase + "_ms", to_string(chrono::duration<double, milli>(now - began).count()));
+        began = now;
+    }
+
+    void count(const string &name, long long value) { add(name, to_string(value)); }
+
+    void print() const {
+        cout << "stats";
+        for (auto &v : values) cout << " " << v.first << "=" << v.second;
+        cout << endl;
+    }
+
+private:
+    void add(const string &name, const string &value) { values.push_back({name, value}); }
+};
+
+// Counts describing the grammar itself
+inline void countGrammar(PhaseStats &stats, const Grammar &g) {
+    stats.count("terminals", g.numTerminals);
+    stats.count("nonterminals", g.numNonTerminals());
+    stats.count("productions", g.numProductions());
+}
@@ -0,0 +1,334 @@
+#pragma once
+
+#include "Grammar.h"
+
+// FIRST and FOLLOW kept up to date while productions are added and removed,
+// for interactive grammar editing (FIRST.cpp and FOLLOW.cpp --edit).
+//
+// Every symbol has a row in FIRST and FOLLOW. As in GrammarBuilder, a symbol
+// with productions is a nonterminal and any other symbol is a terminal,
+// whose FIRST is itself. Terminals get bit columns as they appear; column 0
+// is "#" and column 1 is "$". The epsilon column of FIRST is the nullable
+// flag, so nullable is maintained together with FIRST.
+//
+// Adding a production to a nonterminal can only add bits: the left-hand
+// side is re-evaluated and rows that grow push their dependents (only the
+// symbols reachable from the edit are visited). Removing a production, or
+// giving a terminal its first production, is handled by delete-rederive:
+// the rows that can depend on the edit are cleared and rebuilt from the
+// rows outside that region, which are unaffected.
+class IncrementalGrammar {
+public:
+    // Adds lhs -> rhs (empty rhs = epsilon); the first left-hand side added is the start symbol
+    void addProduction(const string &lhs, const vector<string> &rhs) {
+        int a = symbol(lhs);
+        vector<int> body;
+        for (const string &s : rhs) body.push_back(symbol(s));
+        bool newStart = start < 0;
+        if (newStart) start = a;
+        bool wasTerminal = prodsOf[a].empty();
+
+        int p = prods.size();
+        prods.push_back({a, body});
+        prodsOf[a].push_back(p);
+        for (int i = 0; i < body.size(); i++) usedIn[body[i]].push_back({p, i});
+
+        // a terminal turning into a nonterminal loses its own bit, so that is not monotone
+        vector<int> changed = updateFirst({a}, wasTerminal);
+        vector<int> seeds = followSeeds(changed);
+        seeds.insert(seeds.end(), body.begin(), body.end());
+        if (newStart) seeds.push_back(a);     // "$" goes into FOLLOW(start)
+        updateFollow(seeds, wasTerminal);
+    }
+
+    // Adds a batch of productions and solves everything once
+    void addProductions(const vector<pair<string, vector<string>>> &batch) {
+        for (auto &pr : batch) {
+            int a = symbol(pr.first);
+            vector<int> body;
+            for (const string &s : pr.second) body.push_back(symbol(s));
+            if (start < 0) start = a;
+            int p = prods.size();
+            prods.push_back({a, body});
+            prodsOf[a].push_back(p);
+            for (int i = 0; i < body.size(); i++) usedIn[body[i]].push_back({p, i});
+        }
+        vector<int> all(names.size());
+        iota(all.begin(), all.end(), 0);
+        updateFirst(all, true);
+        updateFollow(all, true);
+    }
+
+    // Adds every production of g (its start symbol first) and solves everything once
+    void addProductions(const Grammar &g) {
+        if (start < 0 && g.start >= 0) start = symbol(g.names[g.start]);
+        vector<pair<string, vector<string>>> batch;
+        for (int p = 0; p < g.numProductions(); p++) {
+            vector<string> body;
+            for (int i = 0; i < g.rhsLength(p); i++) body.push_back(g.names[g.rhs(p)[i]]);
+            batch.push_back({g.names[g.prodLhs[p]], body});
+        }
+        addProductions(batch);
+    }
+
+    // Removes one production lhs -> rhs; returns false if there is none
+    bool removeProduction(const string &lhs, const vector<string> &rhs) {
+        auto it = ids.find(lhs);
+        if (it == ids.end()) return false;
+        int a = it->second;
+        int p = -1;
+        for (int q : prodsOf[a]) {
+            if (prods[q].rhs.size() != rhs.size()) continue;
+            bool same = true;
+            for (int i = 0; i < rhs.size() && same; i++) same = names[prods[q].rhs[i]] == rhs[i];
+            if (same) {
+                p = q;
+                break;
+            }
+        }
+        if (p < 0) return false;
+
+        prodsOf[a].erase(find(prodsOf[a].begin(), prodsOf[a].end(), p));
+        for (int sym : prods[p].rhs) {
+            auto &uses = usedIn[sym];
+            uses.erase(remove_if(uses.begin(), uses.end(),
+                                 [&](const pair<int, int> &u) { return u.first == p; }), uses.end());
+        }
+        if (prodsOf[a].empty()) terminalColumn(a);   // a is a terminal again
+
+        vector<int> changed = updateFirst({a}, true);
+        vector<int> seeds = followSeeds(changed);
+        seeds.insert(seeds.end(), prods[p].rhs.begin(), prods[p].rhs.end());
+        updateFollow(seeds, true);
+        return true;
+    }
+
+    string startSymbol() const { return start < 0 ? "" : names[start]; }
+
+    bool isNonTerminal(const string &name) const {
+        auto it = ids.find(name);
+        return it != ids.end() && !prodsOf[it->second].empty();
+    }
+
+    // Nonterminals in name order
+    vector<string> nonTerminals() const {
+        vector<string> out;
+        for (int x = 0; x < names.size(); x++) {
+            if (!prodsOf[x].empty()) out.push_back(names[x]);
+        }
+        sort(out.begin(), out.end());
+        return out;
+    }
+
+    // Set members in name order ("#" for epsilon, "$" for end of input)
+    vector<string> firstOf(const string &name) const { return members(first, name); }
+    vector<string> followOf(const string &name) const { return members(follow, name); }
+
+    // Rows evaluated by the last edit
+    size_t lastEvaluations() const { return evaluations; }
+
+private:
+    struct Production {
+        int lhs;
+        vector<int> rhs;
+    };
+
+    static const int EPSILON = 0, END = 1;   // fixed columns
+
+    vector<string> names;
+    unordered_map<string, int> ids;
+    vector<int> column;                     // symbol -> terminal column, -1 if none yet
+    vector<string> columnNames = {"#", "$"};
+    vector<Production> prods;              // removed ones stay, unreferenced
+    vector<vector<int>> prodsOf;            // symbol -> live productions
+    vector<vector<pair<int, int>>> usedIn;  // symbol -> (production, position) occurrences
+    BitMatrix first, follow;
+    int columnCapacity = 0;
+    int start = -1;
+    size_t evaluations = 0;
+
+    int symbol(const string &name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        int x = names.size();
+        ids[name] = x;
+        names.push_back(name);
+        column.push_back(-1);
+        prodsOf.emplace_back();
+        usedIn.emplace_back();
+        first.rows++;
+        follow.rows++;
+        first.bits.resize((size_t)first.rows * first.words, 0);
+        follow.bits.resize((size_t)follow.rows * follow.words, 0);
+        // a terminal until it gets a production
+        first.set(x, terminalColumn(x));
+        return x;
+    }
+
+    int terminalColumn(int x) {
+        if (column[x] >= 0) return column[x];
+        column[x] = columnNames.size();
+        columnNames.push_back(names[x]);
+        if (columnNames.size() > columnCapacity) {
+            // double the columns and re-lay both matrices
+            columnCapacity = max<int>(128, columnCapacity * 2);
+            for (BitMatrix *m : {&first, &follow}) {
+                BitMatrix wider(m->rows, columnCapacity);
+                for (int r = 0; r < m->rows; r++) copy(m->row(r), m->row(r) + m->words, wider.row(r));
+                *m = wider;
+            }
+        }
+        return column[x];
+    }
+
+    static void setBit(uint64_t *row, int c) { row[c >> 6] |= 1ULL << (c & 63); }
+    static bool testBit(const uint64_t *row, int c) { return (row[c >> 6] >> (c & 63)) & 1; }
+
+    // FIRST(rhs[from..]) minus epsilon into out; returns true if that suffix is nullable
+    bool firstOfSuffix(const Production &pr, int from, uint64_t *out) const {
+        for (int i = from; i < pr.rhs.size(); i++) {
+            const uint64_t *row = first.row(pr.rhs[i]);
+            for (int w = 0; w < first.words; w++) out[w] |= row[w];
+            out[0] &= ~1ULL;    // EPSILON is column 0
+            if (!testBit(row, EPSILON)) return false;
+        }
+        return true;
+    }
+
+    void evalFirst(int x, uint64_t *out) const {
+        if (prodsOf[x].empty()) {
+            setBit(out, column[x]);
+            return;
+        }
+        bool nullable = false;
+        for (int p : prodsOf[x]) {
+            if (firstOfSuffix(prods[p], 0, out)) nullable = true;
+        }
+        if (nullable) setBit(out, EPSILON);
+    }
+
+    void evalFollow(int x, uint64_t *out) const {
+        if (x == start) setBit(out, END);
+        for (auto &use : usedIn[x]) {
+            const Production &pr = prods[use.first];
+            if (firstOfSuffix(pr, use.second + 1, out)) {
+                const uint64_t *row = follow.row(pr.lhs);
+                for (int w = 0; w < follow.words; w++) out[w] |= row[w];
+            }
+        }
+    }
+
+    // Recomputes sets for the seeds and everything that depends on them.
+    // With reset the dependent region is cleared first and rebuilt; without
+    // it rows only grow. Returns the symbols whose row changed.
+    template <class Eval, class Deps>
+    vector<int> propagate(BitMatrix &sets, const vector<int> &seeds, bool reset, Eval eval, Deps deps) {
+        int n = names.size();
+        vector<char> queued(n, 0), touched(n, 0);
+        vector<int> work, region;
+        for (int x : seeds) {
+            if (!queued[x]) {
+                queued[x] = 1;
+                work.push_back(x);
+            }
+        }
+
+        BitMatrix before;
+        if (reset) {
+            // delete: everything reachable through dependency edges may be stale
+            for (size_t i = 0; i < work.size(); i++) {
+                deps(work[i], [&](int y) {
+                    if (!queued[y]) {
+                        queued[y] = 1;
+                        work.push_back(y);
+                    }
+                });
+            }
+            region = work;
+            before = BitMatrix(region.size(), sets.words * 64);
+            for (int i = 0; i < region.size(); i++) {
+                copy(sets.row(region[i]), sets.row(region[i]) + sets.words, before.row(i));
+                fill(sets.row(region[i]), sets.row(region[i]) + sets.words, 0);
+            }
+        }
+
+        // rederive / grow: chaotic iteration restricted to the worklist
+        vector<uint64_t> value(sets.words);
+        while (!work.empty()) {
+            int x = work.back();
+            work.pop_back();
+            queued[x] = 0;
+            evaluations++;
+            fill(value.begin(), value.end(), 0);
+            eval(x, value.data());
+            if (sets.orRow(x, value.data())) {
+                touched[x] = 1;
+                deps(x, [&](int y) {
+                    if (!queued[y]) {
+                        queued[y] = 1;
+                        work.push_back(y);
+                    }
+                });
+            }
+        }
+
+        vector<int> changed;
+        if (reset) {
+            for (int i = 0; i < region.size(); i++) {
+                if (!equal(before.row(i), before.row(i) + sets.words, sets.row(region[i]))) {
+                    changed.push_back(region[i]);
+                }
+            }
+        } else {
+            for (int x = 0; x < n; x++) {
+                if (touched[x]) changed.push_back(x);
+            }
+        }
+        return changed;
+    }
+
+    vector<int> updateFirst(const vector<int> &seeds, bool reset) {
+        evaluations = 0;
+        // FIRST(x) feeds the left-hand side of every production x appears in
+        return propagate(first, seeds, reset,
+                         [&](int x, uint64_t *out) { evalFirst(x, out); },
+                         [&](int x, auto push) {
+                             for (auto &use : usedIn[x]) push(prods[use.first].lhs);
+                         });
+    }
+
+    void updateFollow(const vector<int> &seeds, bool reset) {
+        // FOLLOW(x) feeds the symbols of x's own productions
+        propagate(follow, seeds, reset,
+                  [&](int x, uint64_t *out) { evalFollow(x, out); },
+                  [&](int x, auto push) {
+                      for (int p : prodsOf[x]) {
+                          for (int sym : prods[p].rhs) push(sym);
+                      }
+                  });
+    }
+
+    // Symbols whose FOLLOW reads FIRST of a changed symbol: those before it in a production
+    vector<int> followSeeds(const vector<int> &changedFirst) const {
+        vector<int> seeds;
+        for (int c : changedFirst) {
+            for (auto &use : usedIn[c]) {
+                const Production &pr = prods[use.first];
+                seeds.insert(seeds.end(), pr.rhs.begin(), pr.rhs.begin() + use.second);
+            }
+        }
+        return seeds;
+    }
+
+    vector<string> members(const BitMatrix &sets, const string &name) const {
+        vector<string> out;
+        auto it = ids.find(name);
+        if (it == ids.end()) return out;
+        const uint64_t *row = sets.row(it->second);
+        for (int c = 0; c < columnNames.size(); c++) {
+            if (testBit(row, c)) out.push_back(columnNames[c]);
+        }
+        sort(out.begin(), out.end());
+        return out;
+    }
+};
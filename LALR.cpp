@@ -4,23 +4,19 @@
 #include <set>
 #include <string>
 #include <algorithm>
+#include "GrammarFile.h"
+#include "GrammarStats.h"
+#include "LRTable.h"
 
 using namespace std;
 
-// Production rule structure
-struct Production {
-    char lhs;
-    string rhs;
-    Production(char l, string r) : lhs(l), rhs(r) {}
-};
-
-// LR(1) Item structure
+// LR(1) Item structure (lookahead is a terminal id)
 struct Item {
     int prodIndex;
     int dotPos;
-    char lookahead;
+    int lookahead;
     
-    Item(int p, int d, char l) : prodIndex(p), dotPos(d), lookahead(l) {}
+    Item(int p, int d, int l) : prodIndex(p), dotPos(d), lookahead(l) {}
     
     bool operator<(const Item& other) const {
         if (prodIndex != other.prodIndex) return prodIndex < other.prodIndex;
@@ -35,101 +31,71 @@ struct Item {
 
 class LALRTableBuilder {
 private:
-    vector<Production> prods;
-    map<pair<int, char>, string> actionTable;
-    map<pair<int, char>, int> gotoTable;
-    
-    bool isNonTerminal(char c) { return c >= 'A' && c <= 'Z'; }
-    bool isTerminal(char c) { return !isNonTerminal(c) && c != '$'; }
+    Grammar g;
+    SuffixFirst suffix;     // FIRST of every production suffix
+    bool example = true;    // the built-in grammar the closing notes describe
+    PhaseStats *stats = nullptr;    // --stats: time the phases instead of printing
+    int numStates = 0;
+    map<pair<int, int>, string> actionTable;
+    map<pair<int, int>, int> gotoTable;
+    vector<string> conflicts;       // ACTION cells claimed twice (see setAction)
     
-    // Compute FIRST sets
-    set<char> first(const string& str) {
-        set<char> result;
-        if (str.empty()) {
-            result.insert('#');
-            return result;
-        }
-        
-        char firstChar = str[0];
-        if (isTerminal(firstChar)) {
-            result.insert(firstChar);
-        } else {
-            // For our grammar
-            if (firstChar == 'S') {
-                result.insert('a');
-                result.insert('(');
-            } else if (firstChar == 'E') {
-                result.insert('a');
-                result.insert('(');
-            } else if (firstChar == 'T') {
-                result.insert('a');
-                result.insert('(');
-            }
-        }
-        return result;
+    // Symbol after the dot, or -1 if the dot is at the end
+    int nextSymbol(int prodIndex, int dotPos) {
+        if (dotPos >= g.rhsLength(prodIndex)) return -1;
+        return g.rhs(prodIndex)[dotPos];
     }
     
-    set<char> firstOfBetaPlusLookahead(const string& beta, char lookahead) {
-        if (beta.empty()) {
-            return {lookahead};
-        }
+    // Lookaheads of items [B -> .gamma] added for [A -> alpha . B beta, a]:
+    // FIRST(beta a) is the precomputed FIRST(beta), plus a if beta is nullable
+    vector<int> firstOfBetaPlusLookahead(const Item& item) {
+        const uint64_t *firstOfBeta = suffix.row(item.prodIndex, item.dotPos + 1);
         
-        set<char> result = first(beta);
-        if (result.find('#') != result.end()) {
-            result.erase('#');
-            result.insert(lookahead);
+        vector<int> lookaheads;
+        for (int w = 0; w < suffix.sets.words; w++) {
+            for (uint64_t bits = firstOfBeta[w]; bits; bits &= bits - 1) {
+                int t = w * 64 + __builtin_ctzll(bits);
+                if (t != g.epsilon) lookaheads.push_back(t);
+            }
         }
-        return result;
+        if (suffix.nullable(item.prodIndex, item.dotPos + 1)) lookaheads.push_back(item.lookahead);
+        return lookaheads;
     }
     
     // Get closure of LR(1) items
     set<Item> getClosure(const set<Item>& items) {
         set<Item> closure = items;
-        bool changed;
+        vector<Item> work(items.begin(), items.end());
         
-        do {
-            changed = false;
-            vector<Item> newItems;
+        while (!work.empty()) {
+            Item item = work.back();
+            work.pop_back();
             
-            for (const auto& item : closure) {
-                const Production& prod = prods[item.prodIndex];
+            int nextSym = nextSymbol(item.prodIndex, item.dotPos);
+            if (nextSym >= 0 && !g.isTerminal(nextSym)) {
+                vector<int> lookaheads = firstOfBetaPlusLookahead(item);
                 
-                if (item.dotPos >= prod.rhs.length()) continue;
-                
-                char nextSym = prod.rhs[item.dotPos];
-                if (isNonTerminal(nextSym)) {
-                    string beta = prod.rhs.substr(item.dotPos + 1);
-                    set<char> lookaheads = firstOfBetaPlusLookahead(beta, item.lookahead);
-                    
-                    for (int i = 0; i < prods.size(); i++) {
-                        if (prods[i].lhs == nextSym) {
-                            for (char la : lookaheads) {
-                                Item newItem(i, 0, la);
-                                if (closure.find(newItem) == closure.end()) {
-                                    newItems.push_back(newItem);
-                                    changed = true;
-                                }
-                            }
+                int r = g.row(nextSym);
+                for (int k = g.lhsStart[r]; k < g.lhsStart[r + 1]; k++) {
+                    for (int la : lookaheads) {
+                        Item newItem(g.byLhs[k], 0, la);
+                        if (closure.insert(newItem).second) {
+                            work.push_back(newItem);
                         }
                     }
                 }
             }
-            
-            for (const auto& item : newItems) {
-                closure.insert(item);
-            }
-        } while (changed);
+        }
         
         return closure;
     }
     
     // Get goto set
-    set<Item> getGoto(const set<Item>& items, char symbol) {
+    set<Item> getGoto(const set<Item>& items, int symbol) {
         set<Item> gotoSet;
         
         for (const auto& item : items) {
-            const Production& prod = prods[item.prodIndex];
-            if (item.dotPos < prod.rhs.length() && prod.rhs[item.dotPos] == symbol) {
+            if (nextSymbol(item.prodIndex, item.dotPos) == symbol) {
                 gotoSet.insert(Item{item.prodIndex, item.dotPos + 1, item.lookahead});
             }
         }
@@ -146,8 +112,8 @@ private:
         return core;
     }
     
-    // Merge states
-    vector<set<Item>> mergeLALRStates(const vector<set<Item>>& lr1States) {
+    // Merge states; mergedInto[i] is the LALR state LR(1) state i ends up in
+    vector<set<Item>> mergeLALRStates(const vector<set<Item>>& lr1States, vector<int>& mergedInto) {
         vector<set<Item>> lalrStates;
         map<set<pair<int, int>>, int> coreToState;
         
@@ -163,6 +129,7 @@ private:
                     lalrStates[stateIndex].insert(item);
                 }
             }
+            mergedInto.push_back(coreToState[core]);
         }
         
         return lalrStates;
@@ -175,56 +142,84 @@ public:
         // E -> E + T | T
         // T -> ( E ) | a
         
-        prods.push_back(Production('X', "S"));   // 0: Augmented
-        prods.push_back(Production('S', "E"));   // 1
-        prods.push_back(Production('E', "E+T")); // 2
-        prods.push_back(Production('E', "T"));   // 3
-        prods.push_back(Production('T', "(E)")); // 4
-        prods.push_back(Production('T', "a"));   // 5
+        GrammarBuilder grammar;
+        grammar.addProduction("S'", {"S"});  // 0: Augmented
+        grammar.addLine("S->E");             // 1
+        grammar.addLine("E->E+T|T");         // 2, 3
+        grammar.addLine("T->(E)|a");         // 4, 5
+        g = grammar.build("S'");
+        suffix = computeSuffixFirst(g, computeFirst(g));
+    }
+    
+    // augmented grammar: production 0 is S' -> S
+    LALRTableBuilder(const Grammar &augmented, PhaseStats *phases = nullptr)
+        : g(augmented), example(false), stats(phases) {
+        if (stats) stats->start();
+        suffix = computeSuffixFirst(g, computeFirst(g));
+        if (stats) stats->stop("first");
     }
     
     void buildTable() {
         // Step 1: Build LR(1) states
         vector<set<Item>> lr1States;
-        map<pair<int, char>, int> transitions;
+        map<set<Item>, int> stateIndex;
+        map<pair<int, int>, int> transitions;
         
         set<Item> initial;
-        initial.insert(Item{0, 0, '$'});
+        initial.insert(Item{0, 0, g.endMarker});
         lr1States.push_back(getClosure(initial));
+        stateIndex[lr1States[0]] = 0;
         
         // Build states
         for (int i = 0; i < lr1States.size(); i++) {
             set<Item> currentState = lr1States[i];
             
-            set<char> symbols;
+            set<int> symbols;
             for (const auto& item : currentState) {
-                const Production& prod = prods[item.prodIndex];
-                if (item.dotPos < prod.rhs.length()) {
-                    symbols.insert(prod.rhs[item.dotPos]);
+                int sym = nextSymbol(item.prodIndex, item.dotPos);
+                if (sym >= 0) {
+                    symbols.insert(sym);
                 }
             }
             
-            for (char sym : symbols) {
+            // in name order, so states are numbered as in the original char-based tables
+            vector<int> order(symbols.begin(), symbols.end());
+            sort(order.begin(), order.end(), [&](int a, int b) { return g.names[a] < g.names[b]; });
+            for (int sym : order) {
                 set<Item> gotoSet = getGoto(currentState, sym);
                 if (!gotoSet.empty()) {
-                    int stateIndex = -1;
-                    for (int j = 0; j < lr1States.size(); j++) {
-                        if (lr1States[j] == gotoSet) {
-                            stateIndex = j;
-                            break;
-                        }
-                    }
-                    
-                    if (stateIndex == -1) {
-                        stateIndex = lr1States.size();
+                    auto found = stateIndex.find(gotoSet);
+                    int target;
+                    if (found == stateIndex.end()) {
+                        target = lr1States.size();
+                        stateIndex[gotoSet] = target;
                         lr1States.push_back(gotoSet);
+                    } else {
+                        target = found->second;
                     }
                     
-                    transitions[{i, sym}] = stateIndex;
+                    transitions[{i, sym}] = target;
                 }
             }
         }
         
+        if (stats) {
+            stats->stop("lr1_automaton");
+            vector<int> mergedInto;
+            vector<set<Item>> lalrStates = mergeLALRStates(lr1States, mergedInto);
+            stats->stop("lalr_merge");
+            buildMergedTable(lalrStates, transitions, mergedInto);
+            stats->stop("lalr_table");
+            size_t items = 0;
+            for (const auto& state : lalrStates) items += state.size();
+            stats->count("lr1_states", lr1States.size());
+            stats->count("states", lalrStates.size());
+            stats->count("items", items);
+            stats->count("actions", actionTable.size());
+            stats->count("conflicts", conflicts.size());
+            return;
+        }
+        
         // Display LR(1) states count
         cout << "LR(1) states generated: " << lr1States.size() << endl;
         
@@ -245,14 +240,7 @@ public:
                 cout << "\nMerge Group " << ++mergeCount << ":\n";
                 cout << "Core: ";
                 for (auto core : entry.first) {
-                    cout << "[" << prods[core.first].lhs << "->";
-                    const string& rhs = prods[core.first].rhs;
-                    for (int j = 0; j < rhs.length(); j++) {
-                        if (j == core.second) cout << ".";
-                        cout << rhs[j];
-                    }
-                    if (core.second == rhs.length()) cout << ".";
-                    cout << "] ";
+                    cout << "[" << itemString(g, core.first, core.second) << "] ";
                 }
                 cout << "\nLR(1) states to merge: ";
                 for (int stateNum : entry.second) {
@@ -261,7 +249,7 @@ public:
                 cout << "\nDifferent lookaheads in these states:\n";
                 
                 // Show different lookaheads
-                set<char> allLookaheads;
+                set<int> allLookaheads;
                 for (int stateNum : entry.second) {
                     for (const auto& item : lr1States[stateNum]) {
                         allLookaheads.insert(item.lookahead);
@@ -269,9 +257,9 @@ public:
                 }
                 cout << "  {";
                 bool first = true;
-                for (char la : allLookaheads) {
+                for (int la : allLookaheads) {
                     if (!first) cout << ", ";
-                    cout << la;
+                    cout << g.names[la];
                     first = false;
                 }
                 cout << "} will be combined in LALR\n";
@@ -279,82 +267,76 @@ public:
         }
         
         // Step 2: Merge to create LALR states
-        vector<set<Item>> lalrStates = mergeLALRStates(lr1States);
+        vector<int> mergedInto;
+        vector<set<Item>> lalrStates = mergeLALRStates(lr1States, mergedInto);
         
         cout << "\nLALR states after merging: " << lalrStates.size() << endl;
         cout << "Reduction: " << lr1States.size() - lalrStates.size() << " fewer states!\n";
         
         // Build tables from merged states
-        buildMergedTable(lr1States, lalrStates);
+        buildMergedTable(lalrStates, transitions, mergedInto);
     }
     
-    void buildMergedTable(const vector<set<Item>>& lr1States, const vector<set<Item>>& lalrStates) {
-        // For simplicity, build a sample LALR table
+    // The tables as integer arrays, after buildTable()
+    LRTables compiled() const { return compileLR(g, numStates, actionTable, gotoTable); }
+    const vector<string>& actionConflicts() const { return conflicts; }
+    
+    void buildMergedTable(const vector<set<Item>>& lalrStates, const map<pair<int, int>, int>& transitions,
+                          const vector<int>& mergedInto) {
+        numStates = lalrStates.size();
+
+        // LR(1) transitions carry over to the merged states
+        for (const auto& t : transitions) {
+            int from = mergedInto[t.first.first];
+            int sym = t.first.second;
+            int to = mergedInto[t.second];
+            if (g.isTerminal(sym)) setAction(g, actionTable, conflicts, from, sym, "s" + to_string(to));
+            else gotoTable[{from, sym}] = to;
+        }
+        
+        // Reductions on the union of the merged lookaheads
+        for (int i = 0; i < lalrStates.size(); i++) {
+            for (const auto& item : lalrStates[i]) {
+                if (item.dotPos < g.rhsLength(item.prodIndex)) continue;
+                if (item.prodIndex == 0) setAction(g, actionTable, conflicts, i, g.endMarker, "acc");
+                else setAction(g, actionTable, conflicts, i, item.lookahead, "r" + to_string(item.prodIndex));
+            }
+        }
         
-        cout << "\nSAMPLE LALR PARSING TABLE:\n";
-        cout << "===========================\n\n";
+        if (stats) return;
         
-        cout << "Grammar:\n";
-        cout << "0: X -> S\n";
-        cout << "1: S -> E\n";
-        cout << "2: E -> E + T\n";
-        cout << "3: E -> T\n";
-        cout << "4: T -> ( E )\n";
-        cout << "5: T -> a\n\n";
+        cout << "\nLALR PARSING TABLE:\n";
+        cout << "====================\n\n";
         
-        set<char> terminals = {'a', '+', '(', ')', '$'};
-        set<char> nonTerminals = {'S', 'E', 'T'};
+        cout << "Grammar:\n";
+        for (int p = 0; p < g.numProductions(); p++) {
+            cout << p << ": " << productionString(g, p) << "\n";
+        }
+        cout << "\n";
         
-        // Sample table (simplified)
         cout << "State\t";
-        for (char t : terminals) cout << t << "\t";
-        for (char nt : nonTerminals) if (nt != 'X') cout << nt << "\t";
+        for (int t = 0; t < g.numTerminals; t++) if (t != g.epsilon) cout << g.names[t] << "\t";
+        for (int nt = g.numTerminals; nt < g.numSymbols(); nt++) if (nt != g.start) cout << g.names[nt] << "\t";
         cout << endl;
         
-        // Hardcoded sample LALR table for this grammar
-        vector<map<char, string>> actionSample = {
-            {{'a', "s5"}, {'(', "s4"}},
-            {{'$', "acc"}},
-            {{'+', "s6"}, {')', "r3"}, {'$', "r3"}},
-            {{'+', "r1"}, {')', "r1"}, {'$', "r1"}},
-            {{'a', "s5"}, {'(', "s4"}},
-            {{'+', "r5"}, {')', "r5"}, {'$', "r5"}},
-            {{'a', "s5"}, {'(', "s4"}},
-            {{'+', "s6"}, {')', "s8"}},
-            {{'+', "r4"}, {')', "r4"}, {'$', "r4"}},
-            {{'+', "r2"}, {')', "r2"}, {'$', "r2"}}
-        };
-        
-        vector<map<char, int>> gotoSample = {
-            {{'S', 1}, {'E', 2}, {'T', 3}},
-            {},
-            {},
-            {},
-            {{'E', 7}, {'T', 3}},
-            {},
-            {{'T', 9}},
-            {},
-            {},
-            {}
-        };
-        
-        for (int i = 0; i < 10; i++) {
+        for (int i = 0; i < lalrStates.size(); i++) {
             cout << i << "\t";
             
             // ACTION
-            for (char t : terminals) {
-                auto it = actionSample[i].find(t);
-                if (it != actionSample[i].end()) {
+            for (int t = 0; t < g.numTerminals; t++) {
+                if (t == g.epsilon) continue;
+                auto it = actionTable.find({i, t});
+                if (it != actionTable.end()) {
                     cout << it->second;
                 }
                 cout << "\t";
             }
             
             // GOTO
-            for (char nt : nonTerminals) {
-                if (nt != 'X') {
-                    auto it = gotoSample[i].find(nt);
-                    if (it != gotoSample[i].end()) {
+            for (int nt = g.numTerminals; nt < g.numSymbols(); nt++) {
+                if (nt != g.start) {
+                    auto it = gotoTable.find({i, nt});
+                    if (it != gotoTable.end()) {
                         cout << it->second;
                     }
                     cout << "\t";
@@ -362,6 +344,12 @@ public:
             }
             cout << endl;
         }
+        if (!conflicts.empty()) {
+            cout << "\nWARNING: ";
+            printLRConflicts(cout, "LALR(1)", conflicts);
+        }
+        
+        if (!example) return;
         
         cout << "\nKEY POINTS ABOUT LALR:\n";
         cout << "======================\n";
@@ -379,7 +367,46 @@ public:
     }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
+    // --grammar file builds the table for a grammar file instead of the example (see GrammarFile.h)
+    // --stats prints phase timings instead of the table (see GrammarStats.h)
+    // --compress reports comb-vector table sizes instead, and with --bench N the parse
+    //   rates on a generated sentence of about N tokens (see LRTable.h); both need a
+    //   table without conflicts
+    const char *grammarFile = nullptr;
+    bool stats = false;
+    bool compress = false;
+    size_t benchTokens = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--grammar" && i + 1 < argc) grammarFile = argv[++i];
+        else if (arg == "--stats") stats = true;
+        else if (arg == "--compress") compress = true;
+        else if (arg == "--bench" && i + 1 < argc) benchTokens = atoll(argv[++i]);
+    }
+    
+    if (grammarFile) {
+        Grammar g;
+        string error;
+        if (!loadGrammarFile(grammarFile, g, error, true)) {
+            cerr << error << "\n";
+            return 1;
+        }
+        PhaseStats phases;
+        if (stats) countGrammar(phases, g);
+        // compressing builds the table through the quiet --stats path
+        LALRTableBuilder parser(g, stats || compress ? &phases : nullptr);
+        parser.buildTable();
+        if (compress && !parser.actionConflicts().empty()) {
+            printLRConflicts(cerr, "LALR(1)", parser.actionConflicts());
+            cerr << "--compress and --bench need a conflict-free table\n";
+            return 1;
+        }
+        if (compress && !reportLRCompression(g, parser.compiled(), benchTokens, stats ? &phases : nullptr)) return 1;
+        if (stats) phases.print();
+        return 0;
+    }
+
     LALRTableBuilder parser;
     parser.buildTable();
     return 0;
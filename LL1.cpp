@@ -1,178 +1,36 @@
 #include <bits/stdc++.h>
+#include "CombTable.h"
+#include "GrammarFile.h"
+#include "GrammarStats.h"
+#include "LLk.h"
+#include "RecursiveDescent.h"
 
 using namespace std;
 
 // Run chcp 65001 to enable unicode input
 
-map<char, vector<string>> grammar;
-set<char> terminals;
-map<char, set<char>> followSet;
-map<char, set<char>> firstSet;
-map<pair<char, char>, set<int>> parseTable;
+// (nonterminal id, terminal id) -> production numbers
+map<pair<int, int>, set<int>> parseTable;
 
-bool isTerminal(char c) {
-    return !(c >= 'A' && c <= 'Z');
-}
-
-set<char> findFirst(string production) {
-    set<char> res;
-    
-    if (production == "#") {
-        res.insert('#');
-        return res;
-    }
-    
-    for (int i = 0; i < production.size(); i++) {
-        char curr = production[i];
-        
-        if (isTerminal(curr)) {
-            res.insert(curr);
-            break;
-        }
-        
-        bool hasEpsilon = false;
-        for (char ch : firstSet[curr]) {
-            if (ch == '#') {
-                hasEpsilon = true;
-            } else {
-                res.insert(ch);
-            }
-        }
-        
-        if (!hasEpsilon) {
-            break;
-        }
+void evaluateLL1ParseTable(const Grammar &g, const SuffixFirst &suffix, const BitMatrix &follow) {
+    // productions are numbered from 1, grouped by nonterminal in name order
+    for (int i = 0; i < g.numProductions(); i++) {
+        int p = g.byLhs[i];
+        int lhs = g.prodLhs[p];
         
-        if (i == production.size() - 1) {
-            res.insert('#');
-        }
-    }
-    
-    return res;
-}
-
-bool findFirstSets() {
-    bool isChanged = false;
-    
-    for (auto p : grammar) {
-        char symbol = p.first;
+        // FIRST of the whole right-hand side comes straight from the suffix table
+        const uint64_t *firstOfRhs = suffix.row(p, 0);
+        bool hasEpsilon = suffix.nullable(p, 0);
         
-        for (string production : grammar[symbol]) {
-            auto res = findFirst(production);
-            size_t before = firstSet[symbol].size();
-            firstSet[symbol].insert(res.begin(), res.end());
-            
-            if (firstSet[symbol].size() > before) {
-                isChanged = true;
+        for (int t = 0; t < g.numTerminals; t++) {
+            if (t == g.epsilon) continue;
+            bool inFirst = (firstOfRhs[t >> 6] >> (t & 63)) & 1;
+            bool inFollow = hasEpsilon && follow.test(g.row(lhs), t);
+            if (inFirst || inFollow) {
+                parseTable[pair<int, int>(lhs, t)].insert(i + 1);
             }
         }
     }
-    
-    return isChanged;
-}
-
-bool findFollowSets() {
-    bool isChanged = false;
-    
-    for (auto p : grammar) {
-        char symbol = p.first;
-        
-        for (string production : grammar[symbol]) {
-            if (production == "#")
-                continue;
-            
-            // Process all symbols except the last one
-            for (int i = 0; i < production.size() - 1; i++) {
-                char currSymbol = production[i];
-                
-                if (isTerminal(production[i])) {
-                    continue;
-                }
-                
-                for (int j = i + 1; j < production.size(); j++) {
-                    bool hasEpsilon = false;
-                    char nextSymbol = production[j];
-                    
-                    if (isTerminal(production[j])) {
-                        auto result = followSet[currSymbol].insert(nextSymbol);
-                        if (result.second) {
-                            isChanged = true;
-                        }
-                        break;
-                    } else {
-                        for (char first : firstSet[production[j]]) {
-                            if (first == '#') {
-                                hasEpsilon = true;
-                            } else {
-                                auto result = followSet[currSymbol].insert(first);
-                                if (result.second) {
-                                    isChanged = true;
-                                }
-                            }
-                        }
-                    }
-                    
-                    if (!hasEpsilon)
-                        break;
-                    
-                    if (j == production.size() - 1) {
-                        size_t before = followSet[currSymbol].size();
-                        followSet[currSymbol].insert(
-                            followSet[symbol].begin(),
-                            followSet[symbol].end()
-                        );
-                        if (followSet[currSymbol].size() > before) {
-                            isChanged = true;
-                        }
-                    }
-                }
-            }
-            
-            // Process last symbol
-            char lastSymbol = production[production.size() - 1];
-            if (!isTerminal(lastSymbol)) {
-                size_t before = followSet[lastSymbol].size();
-                followSet[lastSymbol].insert(
-                    followSet[symbol].begin(),
-                    followSet[symbol].end()
-                );
-                if (followSet[lastSymbol].size() > before) {
-                    isChanged = true;
-                }
-            }
-        }
-    }
-    
-    return isChanged;
-}
-
-void evaluateLL1ParseTable() {
-    int index = 1;
-    
-    for (auto production : grammar) {
-        char lhs = production.first;
-        
-        for (string rhs : production.second) {
-            auto first = findFirst(rhs);
-            bool hasEpsilon = false;
-            
-            for (char symbol : first) {
-                if (symbol == '#') {
-                    hasEpsilon = true;
-                } else {
-                    parseTable[pair<char, char>(lhs, symbol)].insert(index);
-                }
-            }
-            
-            if (hasEpsilon) {
-                for (char symbol : followSet[lhs]) {
-                    parseTable[pair<char, char>(lhs, symbol)].insert(index);
-                }
-            }
-            
-            index++;
-        }
-    }
 }
 
 string modifyInput(string input) {
@@ -196,91 +54,374 @@ string modifyOutput(string output) {
     return output;
 }
 
-int main() {
+// Terminal ids of an input line. Words are whitespace separated; a word
+// that is not a terminal name is split into one-character terminals.
+// Returns false if a symbol is not a terminal of g.
+bool tokenize(const Grammar &g, const string &line, vector<int> &tokens) {
+    istringstream in(line);
+    string word;
+    while (in >> word) {
+        int id = g.id(word);
+        if (id >= 0 && g.isTerminal(id) && id != g.epsilon && id != g.endMarker) {
+            tokens.push_back(id);
+            continue;
+        }
+        for (char c : word) {
+            id = g.id(string(1, c));
+            if (id < 0 || !g.isTerminal(id) || id == g.epsilon || id == g.endMarker) return false;
+            tokens.push_back(id);
+        }
+    }
+    return true;
+}
+
+// Prints the strong LL(k) table, then parses each input line with it.
+// Returns false, without parsing, if the grammar is not strong LL(k).
+bool runLLk(const Grammar &g, int k) {
+    LLkAnalysis ll(g, k);
+
+    cout << "\nLL(" << k << ") Parsing Table:\n";
+    vector<tuple<string, string, int>> entries;    // nonterminal, lookahead, production
+    for (auto &entry : ll.table) {
+        int row = entry.first >> 32, node = (uint32_t)entry.first;
+        entries.push_back({g.names[g.nonTerminal(row)], ll.tupleString(node), entry.second});
+    }
+    sort(entries.begin(), entries.end());
+    for (auto &e : entries) cout << get<0>(e) << "\t" << get<1>(e) << "\t" << get<2>(e) << "\n";
+    cout << ll.trie.size() << " lookahead tuples\n";
+
+    if (!ll.conflicts.empty()) {
+        cerr << "Grammar is NOT strong LL(" << k << "); parsing needs a conflict-free table:\n";
+        for (const string &c : ll.conflicts) cerr << "  " << c << "\n";
+        return false;
+    }
+
+    string line;
+    while (cout << "\nEnter a string to parse: ", getline(cin, line)) {
+        vector<int> tokens, derivation;
+        size_t errorAt = 0;
+        if (!tokenize(g, line, tokens)) {
+            cout << "Unknown terminal in input\n";
+            continue;
+        }
+        if (g.start < 0 || !parseLLk(ll, tokens, derivation, errorAt)) {
+            cout << "Syntax error at token " << errorAt + 1 << "\n";
+            continue;
+        }
+        cout << "Accepted; leftmost derivation:";
+        for (int number : derivation) cout << " " << number;
+        cout << "\n";
+    }
+    cout << "\n";
+    return true;
+}
+
+// Parses a file of whitespace separated terminals (split as in tokenize())
+bool parseTokenFile(const Grammar &g, const LL1Table &table, const char *path, LL1Output output) {
+    ifstream in(path);
+    if (!in) {
+        cerr << path << ": cannot open\n";
+        return false;
+    }
+    vector<int> ids;
+    string line;
+    for (int lineNumber = 1; getline(in, line); lineNumber++) {
+        if (!tokenize(g, line, ids)) {
+            cerr << path << ":" << lineNumber << ": unknown terminal\n";
+            return false;
+        }
+    }
+    vector<int32_t> tokens(ids.begin(), ids.end());
+    tokens.push_back(g.endMarker);
+
+    // LL1 numbers productions from 1 in g.byLhs order
+    vector<int> number(g.numProductions());
+    for (int i = 0; i < g.numProductions(); i++) number[g.byLhs[i]] = i + 1;
+
+    size_t errorAt = 0;
+    vector<int> derivation;
+    ParseTree tree;
+    bool ok = output == TREE ? parseLL1<TREE>(table, g.start, tokens.data(), tokens.size(), errorAt, nullptr, &tree)
+            : output == DERIVATION ? parseLL1<DERIVATION>(table, g.start, tokens.data(), tokens.size(), errorAt, &derivation)
+            : parseLL1<RECOGNIZE>(table, g.start, tokens.data(), tokens.size(), errorAt);
+    if (!ok) {
+        cout << "Syntax error at token " << errorAt + 1 << "\n";
+        return false;
+    }
+    cout << "Accepted " << ids.size() << " tokens\n";
+    if (output == DERIVATION) {
+        cout << "Leftmost derivation:\n";
+        for (int p : derivation) cout << number[p] << ": " << productionString(g, p) << "\n";
+    } else if (output == TREE) {
+        vector<int> depth(tree.symbol.size(), 0);
+        for (size_t x = 0; x < tree.symbol.size(); x++) {
+            if (tree.parent[x] >= 0) depth[x] = depth[tree.parent[x]] + 1;
+            cout << string(2 * depth[x], ' ') << g.names[tree.symbol[x]] << "\n";
+        }
+    }
+    return true;
+}
+
+// Best of 5 runs in seconds, so page faults on the first run are taken out
+template <class Run>
+double bestOf5(Run run) {
+    double best = -1;
+    for (int r = 0; r < 5; r++) {
+        auto begin = chrono::steady_clock::now();
+        run();
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        if (best < 0 || secs < best) best = secs;
+    }
+    return best;
+}
+
+// Sizes of the dense table and its comb-vector copies (--compress)
+void reportCompression(const LL1Table &table, const CombTable<int16_t> &comb, const CombTable<int16_t> &elided,
+                       PhaseStats *stats) {
+    size_t dense = table.cells.size() * sizeof(int16_t);
+    if (stats) {
+        stats->count("dense_bytes", dense);
+        stats->count("comb_bytes", comb.bytes());
+        stats->count("comb_default_bytes", elided.bytes());
+        return;
+    }
+    cout << "Dense table:          " << dense << " bytes\n"
+         << "Comb vector:          " << comb.bytes() << " bytes (" << (double)dense / comb.bytes() << "x smaller)\n"
+         << "Comb vector, default: " << elided.bytes() << " bytes (" << (double)dense / elided.bytes()
+         << "x smaller)\n";
+}
+
+// Parses a generated sentence of about n tokens and reports tokens per
+// second; with compress the comb-vector tables are timed on it too. Returns
+// false if no sentence of about n tokens could be generated.
+bool benchDenseParser(const Grammar &g, const LL1Table &table, size_t n, bool compress, PhaseStats *stats) {
+    mt19937 rng(12345);
+    vector<int32_t> tokens;
+    if (!generateSentence(g, rng, n, tokens)) {
+        cerr << "Cannot generate a sentence of about " << n << " tokens (got " << tokens.size() << ")\n";
+        return false;
+    }
+    tokens.push_back(g.endMarker);
+    size_t count = tokens.size() - 1;
+
+    bool ok = true;
+    size_t errorAt = 0;
+    double best = bestOf5([&] { ok = parseLL1<RECOGNIZE>(table, g.start, tokens.data(), tokens.size(), errorAt); });
+    if (stats) {
+        stats->count("tokens", count);
+        stats->count("accepted", ok);
+        stats->count("tokens_per_sec", (long long)(count / best));
+    } else {
+        cout << (ok ? "Accepted " : "Rejected ") << count << " tokens in " << best * 1000 << " ms ("
+             << (size_t)(count / best) << " tokens/sec)\n";
+    }
+
+    if (compress) {
+        int rows = g.numNonTerminals();
+        auto comb = compressTable<int16_t>(table.cells.data(), rows, table.numTerminals, -1, false);
+        auto elided = compressTable<int16_t>(table.cells.data(), rows, table.numTerminals, -1, true);
+        reportCompression(table, comb, elided, stats);
+        auto combLookup = [&](int row, int32_t t) { return comb.at(row, t); };
+        auto elidedLookup = [&](int row, int32_t t) { return elided.at(row, t); };
+        double combBest = bestOf5([&] {
+            ok = parseLL1With<RECOGNIZE>(table, combLookup, g.start, tokens.data(), tokens.size(), errorAt);
+        });
+        double elidedBest = bestOf5([&] {
+            ok = parseLL1With<RECOGNIZE>(table, elidedLookup, g.start, tokens.data(), tokens.size(), errorAt);
+        });
+
+        // the compressed tables must reject exactly what the dense one rejects, at the same token
+        const int TRIALS = 500;
+        vector<int32_t> shortSentence;
+        generateSentence(g, rng, min<size_t>(n, 1000), shortSentence);
+        shortSentence.push_back(g.endMarker);
+        auto parser = [&](auto lookup) {
+            return [=, &table, &g](const vector<int32_t> &input, size_t &at) {
+                return parseLL1With<RECOGNIZE>(table, lookup, g.start, input.data(), input.size(), at);
+            };
+        };
+        const int16_t *cells = table.cells.data();
+        int terminals = table.numTerminals;
+        size_t mismatches = countDisagreements(
+            g, rng, shortSentence, TRIALS,
+            {parser([=](int row, int32_t t) { return cells[(size_t)row * terminals + t]; }), parser(combLookup),
+             parser(elidedLookup)});
+
+        if (stats) {
+            stats->count("comb_tokens_per_sec", (long long)(count / combBest));
+            stats->count("comb_default_tokens_per_sec", (long long)(count / elidedBest));
+            stats->count("reject_mismatches", mismatches);
+        } else {
+            cout << "Comb vector:          " << count << " tokens, " << (size_t)(count / combBest) << " tokens/sec\n"
+                 << "Comb vector, default: " << count << " tokens, " << (size_t)(count / elidedBest)
+                 << " tokens/sec\n"
+                 << "Mutated inputs:       " << TRIALS << " checked, " << mismatches << " parsed differently\n";
+        }
+    }
+    if (stats) stats->print();
+    return true;
+}
+
+int main(int argc, char *argv[]) {
     int n;
-    char startSymbol;
+    GrammarBuilder grammar;
     
-    cout << "Enter the number of productions: ";
-    cin >> n;
-    cin.ignore();
+    // -j N solves the FIRST/FOLLOW inclusion graphs on N threads
+    // --grammar file reads the grammar from a file instead of prompting (see GrammarFile.h)
+    // --stats prints phase timings instead of the result (see GrammarStats.h)
+    // -k N builds a strong LL(N) table instead and parses input lines with it (see LLk.h)
+    // --parse file parses a token file with the dense table (see LL1Parser.h),
+    //   printing the leftmost derivation with --derivation or the parse tree with --tree
+    // --bench N times the dense parser on a generated sentence of about N tokens
+    // --compress reports the comb-vector table sizes, and with --bench their parse rates (see CombTable.h)
+    // --emit-rd file writes a recursive-descent parser for the grammar (see RecursiveDescent.h)
+    //   in namespace rd, or the one given by --namespace
+    int threads = 1;
+    int k = 1;
+    const char *grammarFile = nullptr;
+    bool stats = false;
+    const char *parseFile = nullptr;
+    LL1Output output = RECOGNIZE;
+    size_t benchTokens = 0;
+    bool compress = false;
+    const char *rdFile = nullptr;
+    string rdNamespace = "rd";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) threads = max(1, atoi(argv[++i]));
+        else if (arg == "-k" && i + 1 < argc) k = max(1, atoi(argv[++i]));
+        else if (arg == "--grammar" && i + 1 < argc) grammarFile = argv[++i];
+        else if (arg == "--stats") stats = true;
+        else if (arg == "--parse" && i + 1 < argc) parseFile = argv[++i];
+        else if (arg == "--derivation") output = DERIVATION;
+        else if (arg == "--tree") output = TREE;
+        else if (arg == "--bench" && i + 1 < argc) benchTokens = atoll(argv[++i]);
+        else if (arg == "--compress") compress = true;
+        else if (arg == "--emit-rd" && i + 1 < argc) rdFile = argv[++i];
+        else if (arg == "--namespace" && i + 1 < argc) rdNamespace = argv[++i];
+    }
     
-    for (int i = 0; i < n; i++) {
-        cout << "Enter the production " << i + 1 << ": ";
-        string production;
-        getline(cin, production);
-        production = modifyInput(production);
-        
-        char lhs = production[0];
-        string rhs = production.substr(3);
-        
-        if (i == 0) {
-            startSymbol = lhs;
+    Grammar g;
+    if (grammarFile) {
+        string error;
+        if (!loadGrammarFile(grammarFile, g, error)) {
+            cerr << error << "\n";
+            return 1;
         }
+    } else {
+        cout << "Enter the number of productions: ";
+        cin >> n;
+        cin.ignore();
+    
+        for (int i = 0; i < n; i++) {
+            cout << "Enter the production " << i + 1 << ": ";
+            string production;
+            getline(cin, production);
+            production = modifyInput(production);
         
-        string temp = "";
-        for (char c : rhs) {
-            if (c == '|') {
-                grammar[lhs].push_back(temp);
-                temp = "";
-            } else {
-                temp += c;
-                if (isTerminal(c) && c != '#') {
-                    terminals.insert(c);
-                }
-            }
+            // the first production's left-hand side is the start symbol
+            grammar.addLine(production);
         }
-        grammar[lhs].push_back(temp);
+        g = grammar.build();
     }
     
+    if (k > 1) {
+        return runLLk(g, k) ? 0 : 1;
+    }
+
+    PhaseStats phases;
+    if (stats) countGrammar(phases, g);
+    phases.start();
+
     // Calculate FIRST sets
-    while (findFirstSets());
-    
-    // Initialize FOLLOW set for start symbol
-    followSet[startSymbol].insert('$');
-    terminals.insert('$');
+    BitMatrix first = computeFirst(g, threads);
     
-    // Calculate FOLLOW sets
-    while (findFollowSets());
+    // Calculate FOLLOW sets ('$' goes into FOLLOW of the start symbol)
+    phases.stop("first");
+    BitMatrix follow = computeFollow(g, first, threads);
+    phases.stop("follow");
     
     // Build LL(1) parse table
-    evaluateLL1ParseTable();
+    SuffixFirst suffix = computeSuffixFirst(g, first);
+    evaluateLL1ParseTable(g, suffix, follow);
+    phases.stop("ll1_table");
+    
+    if (parseFile || benchTokens || rdFile || compress) {
+        LL1Table table;
+        if (!compileLL1(g, suffix, follow, table)) {
+            cerr << "Too many productions for the dense LL(1) table\n";
+            return 1;
+        }
+        phases.stop("dense_table");
+        if (table.conflicts > 0) {
+            cerr << "Grammar is NOT LL(1) (" << table.conflicts << " conflicting cells); --parse, --bench, "
+                 << "--emit-rd and --compress need an LL(1) table, try -k 2\n";
+            return 1;
+        }
+        if (rdFile) {
+            ofstream out(rdFile);
+            emitRecursiveDescent(g, table, rdNamespace, out);
+            if (!out) {
+                cerr << rdFile << ": cannot write\n";
+                return 1;
+            }
+            return 0;
+        }
+        if (parseFile) return parseTokenFile(g, table, parseFile, output) ? 0 : 1;
+        if (benchTokens) {
+            return benchDenseParser(g, table, benchTokens, compress, stats ? &phases : nullptr) ? 0 : 1;
+        }
+        int rows = g.numNonTerminals();
+        reportCompression(table, compressTable<int16_t>(table.cells.data(), rows, table.numTerminals, -1, false),
+                          compressTable<int16_t>(table.cells.data(), rows, table.numTerminals, -1, true),
+                          stats ? &phases : nullptr);
+        if (stats) phases.print();
+        return 0;
+    }
     
     // Check if grammar is LL(1)
-    // bool isLL1 = true;
-    // for (auto entry : parseTable) {
-    //     if (entry.second.size() > 1) {
-    //         isLL1 = false;
-    //         break;
-    //     }
-    // }
+    bool isLL1 = true;
+    for (auto entry : parseTable) {
+        if (entry.second.size() > 1) {
+            isLL1 = false;
+            break;
+        }
+    }
     
-    // if (!isLL1) {
-    //     cout << "\nWARNING: Grammar is NOT LL(1) (multiple entries in parse table)\n";
-    // }
+    if (stats) {
+        phases.count("table_entries", parseTable.size());
+        phases.count("ll1", isLL1);
+        phases.print();
+        return 0;
+    }
+    
+    if (!isLL1) {
+        cout << "\nWARNING: Grammar is NOT LL(1) (multiple entries in parse table); try -k 2\n";
+    }
     
     // // Display production mapping
     // cout << "\nProduction Mapping:\n";
-    // int idx = 1;
-    // for (auto p : grammar) {
-    //     for (string prod : p.second) {
-    //         cout << idx++ << ": " << p.first << " -> " << modifyOutput(prod) << "\n";
-    //     }
+    // for (int i = 0; i < g.numProductions(); i++) {
+    //     int p = g.byLhs[i];
+    //     cout << i + 1 << ": " << g.names[g.prodLhs[p]] << " ->";
+    //     for (int k = 0; k < g.rhsLength(p); k++) cout << " " << g.names[g.rhs(p)[k]];
+    //     cout << "\n";
     // }
     
     // // Display FIRST sets
     // cout << "\nFIRST sets:\n";
-    // for (auto p : grammar) {
-    //     cout << "FIRST(" << p.first << ") = { ";
-    //     for (char s : firstSet[p.first])
-    //         cout << modifyOutput(string(1, s)) << " ";
+    // for (int a = 0; a < g.numNonTerminals(); a++) {
+    //     cout << "FIRST(" << g.names[g.nonTerminal(a)] << ") = { ";
+    //     for (const string &s : setSymbols(g, first, g.nonTerminal(a)))
+    //         cout << modifyOutput(s) << " ";
     //     cout << "}\n";
     // }
     
     // // Display FOLLOW sets
     // cout << "\nFOLLOW sets:\n";
-    // for (auto p : grammar) {
-    //     cout << "FOLLOW(" << p.first << ") = { ";
-    //     for (char s : followSet[p.first])
+    // for (int a = 0; a < g.numNonTerminals(); a++) {
+    //     cout << "FOLLOW(" << g.names[g.nonTerminal(a)] << ") = { ";
+    //     for (const string &s : setSymbols(g, follow, g.nonTerminal(a)))
     //         cout << s << " ";
     //     cout << "}\n";
     // }
@@ -288,17 +429,18 @@ int main() {
     // Display LL(1) Parsing Table
     cout << "\nLL(1) Parsing Table:\n";
     cout << "\t";
-    for (auto terminal : terminals) {
-        cout << terminal << "\t";
+    for (int t = 0; t < g.numTerminals; t++) {
+        if (t != g.epsilon) cout << g.names[t] << "\t";
     }
     cout << endl;
     
-    for (auto p : grammar) {
-        char row = p.first;
-        cout << row << "\t";
+    for (int a = 0; a < g.numNonTerminals(); a++) {
+        int row = g.nonTerminal(a);
+        cout << g.names[row] << "\t";
         
-        for (auto col : terminals) {
-            pair<char, char> key(row, col);
+        for (int col = 0; col < g.numTerminals; col++) {
+            if (col == g.epsilon) continue;
+            pair<int, int> key(row, col);
             
             if (parseTable.find(key) != parseTable.end()) {
                 auto productions = parseTable[key];
@@ -0,0 +1,314 @@
+#pragma once
+
+#include "Grammar.h"
+
+// Dense LL(1) table and an explicit-stack predictive parser (LL1 --parse, --bench).
+//
+// The table is one int16_t array, a row per nonterminal and a column per
+// terminal id, holding the predicted production or -1. Right-hand sides are
+// flattened into one array, each stored reversed so a prediction is pushed
+// onto the parse stack with a single copy. Input is a buffer of terminal
+// ids ending in "$".
+struct LL1Table {
+    int numTerminals = 0;
+    int firstNonTerminal = 0;       // g.numTerminals: row of nonterminal x is x - firstNonTerminal
+    vector<int16_t> cells;          // [row * numTerminals + terminal] -> production, -1 = error
+    vector<int32_t> rhsStart;       // production p pushes reversedRhs[rhsStart[p] .. rhsStart[p + 1])
+    vector<int32_t> reversedRhs;
+    int conflicts = 0;              // cells claimed by more than one production (first one kept)
+
+    int16_t at(int nonTerminal, int terminal) const {
+        return cells[(size_t)(nonTerminal - firstNonTerminal) * numTerminals + terminal];
+    }
+};
+
+// Builds the dense table from the suffix FIRST sets and FOLLOW. Returns false
+// if the grammar has more productions than an int16_t cell can name.
+inline bool compileLL1(const Grammar &g, const SuffixFirst &suffix, const BitMatrix &follow, LL1Table &table) {
+    if (g.numProductions() > INT16_MAX) return false;
+    table.numTerminals = g.numTerminals;
+    table.firstNonTerminal = g.numTerminals;
+    table.cells.assign((size_t)g.numNonTerminals() * g.numTerminals, -1);
+    table.conflicts = 0;
+
+    table.rhsStart.assign(1, 0);
+    table.reversedRhs.clear();
+    for (int p = 0; p < g.numProductions(); p++) {
+        for (int i = g.rhsLength(p) - 1; i >= 0; i--) table.reversedRhs.push_back(g.rhs(p)[i]);
+        table.rhsStart.push_back(table.reversedRhs.size());
+    }
+
+    // in the same order as LL1's numbering, so the first production listed wins a conflict
+    for (int i = 0; i < g.numProductions(); i++) {
+        int p = g.byLhs[i];
+        int a = g.row(g.prodLhs[p]);
+        const uint64_t *firstOfRhs = suffix.row(p, 0);
+        const uint64_t *followOfLhs = follow.row(a);
+        bool nullable = suffix.nullable(p, 0);
+        int16_t *row = table.cells.data() + (size_t)a * g.numTerminals;
+        for (int w = 0; w < follow.words; w++) {
+            uint64_t bits = firstOfRhs[w] | (nullable ? followOfLhs[w] : 0);
+            while (bits) {
+                int t = w * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                if (t == g.epsilon) continue;
+                if (row[t] < 0) row[t] = p;
+                else if (row[t] != p) table.conflicts++;
+            }
+        }
+    }
+    return true;
+}
+
+// Parse tree in preorder: node 0 is the start symbol, and every node comes
+// after its parent and after its left siblings' subtrees
+struct ParseTree {
+    vector<int> symbol;
+    vector<int> parent;     // -1 for the root
+    vector<int> token;      // input position of a terminal node, -1 for nonterminals
+};
+
+enum LL1Output { RECOGNIZE, DERIVATION, TREE };
+
+// Parses tokens[0 .. n), which must end with "$". With DERIVATION the
+// predicted productions are appended to derivation (a leftmost derivation),
+// with TREE the parse tree is built. On a syntax error returns false with
+// errorAt set to the offending token index. lookup(row, terminal) gives the
+// predicted production, so the same driver runs over the dense cells or a
+// compressed copy of them (see CombTable.h). The stack is capped at
+// LL1_MAX_STACK symbols; a table with conflicts resolved first-wins (say for
+// E -> E + T) can otherwise predict forever, and the parse fails there.
+const size_t LL1_MAX_STACK = size_t(1) << 24;
+
+template <LL1Output Mode, class Lookup>
+bool parseLL1With(const LL1Table &table, Lookup lookup, int start, const int32_t *tokens, size_t n, size_t &errorAt,
+                  vector<int> *derivation = nullptr, ParseTree *tree = nullptr) {
+    const int terminals = table.numTerminals;
+    const int32_t *rhsStart = table.rhsStart.data();
+    const int32_t *reversed = table.reversedRhs.data();
+
+    // the stack holds symbols; in TREE mode each entry also holds its parent node
+    vector<int32_t> stack(1024), parents(Mode == TREE ? 1024 : 0);
+    size_t sp = 0, pos = 0;
+    stack[sp++] = start;
+    if (Mode == TREE) {
+        parents[0] = -1;
+        tree->symbol.clear();
+        tree->parent.clear();
+        tree->token.clear();
+    }
+
+    while (sp > 0) {
+        int top = stack[--sp];
+        int node = -1;
+        if (Mode == TREE) {
+            node = tree->symbol.size();
+            tree->symbol.push_back(top);
+            tree->parent.push_back(parents[sp]);
+            tree->token.push_back(top < terminals ? (int)pos : -1);
+        }
+        if (top < terminals) {
+            if (pos >= n || tokens[pos] != top) {
+                errorAt = pos;
+                return false;
+            }
+            pos++;
+            continue;
+        }
+
+        int p = pos < n ? lookup(top - terminals, tokens[pos]) : -1;
+        if (p < 0) {
+            errorAt = pos;
+            return false;
+        }
+        if (Mode == DERIVATION) derivation->push_back(p);
+
+        size_t len = rhsStart[p + 1] - rhsStart[p];
+        if (sp + len > stack.size()) {
+            if (sp + len > LL1_MAX_STACK) {
+                errorAt = pos;
+                return false;
+            }
+            stack.resize(min(2 * (sp + len), LL1_MAX_STACK));
+            if (Mode == TREE) parents.resize(stack.size());
+        }
+        memcpy(stack.data() + sp, reversed + rhsStart[p], len * sizeof(int32_t));
+        if (Mode == TREE) fill(parents.begin() + sp, parents.begin() + sp + len, node);
+        sp += len;
+    }
+
+    // everything but the final "$" must be consumed
+    if (pos + 1 != n) {
+        errorAt = pos;
+        return false;
+    }
+    return true;
+}
+
+template <LL1Output Mode>
+bool parseLL1(const LL1Table &table, int start, const int32_t *tokens, size_t n, size_t &errorAt,
+              vector<int> *derivation = nullptr, ParseTree *tree = nullptr) {
+    const int terminals = table.numTerminals;
+    const int16_t *cells = table.cells.data();
+    auto dense = [=](int row, int32_t terminal) { return cells[(size_t)row * terminals + terminal]; };
+    return parseLL1With<Mode>(table, dense, start, tokens, n, errorAt, derivation, tree);
+}
+
+// A random sentence of about targetTokens terminals (without "$"), derived
+// from start. Productions are picked at random until the target is reached,
+// then by least derivation height so the sentence closes quickly. While
+// more than maxPending symbols wait on the stack the least-height choice is
+// taken too, which keeps nesting (and recursive-descent depth) realistic.
+// A nonterminal that can derive arbitrarily long sentences is never let go
+// early: when it is the last such symbol pending and the target is not
+// reached, one of its productions that keeps such a symbol is picked.
+// Returns false if the sentence (left in out) is shorter than half the
+// target, which happens when the grammar's sentences are all short or start
+// derives no terminal string.
+inline bool generateSentence(const Grammar &g, mt19937 &rng, size_t targetTokens, vector<int32_t> &out,
+                             size_t maxPending = 64) {
+    const int INF = INT_MAX / 2;
+    vector<int> height(g.numNonTerminals(), INF), best(g.numNonTerminals(), -1);
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (int p = 0; p < g.numProductions(); p++) {
+            int h = 0;
+            for (int i = 0; i < g.rhsLength(p) && h < INF; i++) {
+                int sym = g.rhs(p)[i];
+                if (!g.isTerminal(sym)) h = max(h, height[g.row(sym)]);
+            }
+            if (h >= INF) continue;
+            int a = g.row(g.prodLhs[p]);
+            if (h + 1 < height[a]) {
+                height[a] = h + 1;
+                best[a] = p;
+                changed = true;
+            }
+        }
+    }
+    out.clear();
+    if (g.start < 0 || height[g.row(g.start)] >= INF) return false;
+
+    auto finite = [&](int p) {
+        for (int i = 0; i < g.rhsLength(p); i++) {
+            int s = g.rhs(p)[i];
+            if (!g.isTerminal(s) && height[g.row(s)] >= INF) return false;
+        }
+        return true;
+    };
+
+    // growing[a]: a reaches a cycle through finite productions, so its sentences
+    // are unbounded. Nonterminals that only reach bounded ones are peeled off
+    // from the bottom up; whatever is left grows.
+    int rows = g.numNonTerminals();
+    vector<int> pendingEdges(rows, 0);
+    vector<vector<int>> usedBy(rows);
+    for (int p = 0; p < g.numProductions(); p++) {
+        if (!finite(p)) continue;
+        int a = g.row(g.prodLhs[p]);
+        for (int i = 0; i < g.rhsLength(p); i++) {
+            int s = g.rhs(p)[i];
+            if (g.isTerminal(s)) continue;
+            usedBy[g.row(s)].push_back(a);
+            pendingEdges[a]++;
+        }
+    }
+    vector<char> growing(rows, 1);
+    vector<int> bounded;
+    for (int a = 0; a < rows; a++) {
+        if (pendingEdges[a] == 0) bounded.push_back(a);
+    }
+    while (!bounded.empty()) {
+        int b = bounded.back();
+        bounded.pop_back();
+        growing[b] = 0;
+        for (int a : usedBy[b]) {
+            if (--pendingEdges[a] == 0) bounded.push_back(a);
+        }
+    }
+    auto grows = [&](int sym) { return !g.isTerminal(sym) && growing[g.row(sym)]; };
+    auto keepsGrowing = [&](int p) {
+        if (!finite(p)) return false;
+        for (int i = 0; i < g.rhsLength(p); i++) {
+            if (grows(g.rhs(p)[i])) return true;
+        }
+        return false;
+    };
+
+    vector<int> stack = {g.start};
+    size_t growingPending = grows(g.start);
+    // a cyclic grammar (A =>+ A) can keep growing without output
+    size_t steps = 0, maxSteps = 64 * (targetTokens + 1) + 1000000;
+    vector<int> choices;
+    while (!stack.empty() && steps++ < maxSteps) {
+        int sym = stack.back();
+        stack.pop_back();
+        if (g.isTerminal(sym)) {
+            out.push_back(sym);
+            continue;
+        }
+        if (grows(sym)) growingPending--;
+        int a = g.row(sym), p = best[a];
+        int count = g.lhsStart[a + 1] - g.lhsStart[a];
+        bool below = out.size() + stack.size() < targetTokens;
+        if (below && growing[a] && growingPending == 0) {
+            // the last symbol that can still reach the target
+            choices.clear();
+            for (int k = g.lhsStart[a]; k < g.lhsStart[a + 1]; k++) {
+                if (keepsGrowing(g.byLhs[k])) choices.push_back(g.byLhs[k]);
+            }
+            if (!choices.empty()) p = choices[rng() % choices.size()];
+        } else if (below && stack.size() < maxPending) {
+            // a random production that can still finish
+            for (int tries = 0; tries < 4; tries++) {
+                int q = g.byLhs[g.lhsStart[a] + rng() % count];
+                if (finite(q)) {
+                    p = q;
+                    break;
+                }
+            }
+        }
+        for (int i = g.rhsLength(p) - 1; i >= 0; i--) {
+            stack.push_back(g.rhs(p)[i]);
+            if (grows(g.rhs(p)[i])) growingPending++;
+        }
+    }
+    return stack.empty() && out.size() * 2 >= targetTokens;
+}
+
+// Checks that several layouts of one parse table agree on bad input: each of
+// trials copies of sentence (which ends with "$") gets a random token
+// replaced, deleted or inserted, and every parser must accept or reject it
+// at the same token as parsers[0]. Returns the number of copies they
+// disagree on.
+inline size_t countDisagreements(const Grammar &g, mt19937 &rng, const vector<int32_t> &sentence, int trials,
+                                 const vector<function<bool(const vector<int32_t> &, size_t &)>> &parsers) {
+    vector<int32_t> terminals;
+    for (int t = 0; t < g.numTerminals; t++) {
+        if (t != g.epsilon) terminals.push_back(t);
+    }
+    size_t disagreements = 0;
+    for (int trial = 0; trial < trials; trial++) {
+        vector<int32_t> input = sentence;
+        size_t at = rng() % input.size();
+        int32_t t = terminals[rng() % terminals.size()];
+        switch (rng() % 3) {
+        case 0: input[at] = t; break;
+        case 1: input.erase(input.begin() + at); break;
+        default: input.insert(input.begin() + at, t); break;
+        }
+        if (input.empty() || input.back() != g.endMarker) input.push_back(g.endMarker);
+
+        size_t firstError = 0;
+        bool firstOk = parsers[0](input, firstError);
+        for (size_t k = 1; k < parsers.size(); k++) {
+            size_t errorAt = 0;
+            bool ok = parsers[k](input, errorAt);
+            if (ok != firstOk || (!ok && errorAt != firstError)) {
+                disagreements++;
+                break;
+            }
+        }
+    }
+    return disagreements;
+}
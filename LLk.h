@@ -0,0 +1,235 @@
+#pragma once
+
+#include "LL1Parser.h"
+
+// FIRST_k / FOLLOW_k and a strong LL(k) table and parser (LL1 -k N).
+//
+// Lookahead strings are terminal tuples of length <= k. Each one is
+// hash-consed as a node of a trie (TupleTrie), so a tuple is a single
+// int and tuples with a common prefix share storage. A set of tuples is
+// a sorted vector of node ids. A tuple shorter than k is either a
+// complete terminal string (in FIRST_k) or ends in "$".
+//
+// The table is strong LL(k): production p of A is predicted on
+// FIRST_k(rhs(p)) concatenated with FOLLOW_k(A), truncated to k.
+
+// Trie of terminal tuples; node 0 is the empty tuple
+class TupleTrie {
+    vector<int> parent, last, depth;        // per node
+    unordered_map<uint64_t, int> children;  // (node, terminal) -> node
+
+    static uint64_t key(int node, int t) { return (uint64_t)node << 32 | (uint32_t)t; }
+
+public:
+    TupleTrie() : parent{-1}, last{-1}, depth{0} {}
+
+    int size() const { return parent.size(); }
+    int length(int node) const { return depth[node]; }
+    int lastSymbol(int node) const { return last[node]; }
+
+    // node + t, created if needed
+    int extend(int node, int t) {
+        auto it = children.find(key(node, t));
+        if (it != children.end()) return it->second;
+        int id = parent.size();
+        parent.push_back(node);
+        last.push_back(t);
+        depth.push_back(depth[node] + 1);
+        children.emplace(key(node, t), id);
+        return id;
+    }
+
+    // node + t if that tuple exists, otherwise -1
+    int find(int node, int t) const {
+        auto it = children.find(key(node, t));
+        return it == children.end() ? -1 : it->second;
+    }
+
+    // Symbols of a tuple, first to last
+    vector<int> symbols(int node) const {
+        vector<int> out(depth[node]);
+        for (int i = depth[node] - 1; i >= 0; i--, node = parent[node]) out[i] = last[node];
+        return out;
+    }
+};
+
+typedef vector<int> TupleSet;   // sorted trie node ids
+
+class LLkAnalysis {
+public:
+    const Grammar &g;
+    int k;
+    TupleTrie trie;
+    vector<TupleSet> first;     // per nonterminal row
+    vector<TupleSet> follow;    // per nonterminal row
+
+    // productions are numbered from 1, grouped by nonterminal as in LL1
+    // (number - 1 indexes g.byLhs); table maps (nonterminal row, tuple) to
+    // the predicted production number
+    unordered_map<uint64_t, int> table;
+    vector<string> conflicts;   // one line per clashing lookahead
+
+    LLkAnalysis(const Grammar &grammar, int lookahead) : g(grammar), k(lookahead) {
+        computeFirstK();
+        computeFollowK();
+        buildTable();
+    }
+
+    // Whether a tuple is complete, i.e. cannot be extended by what follows
+    bool complete(int node) const {
+        return trie.length(node) == k || (node != 0 && trie.lastSymbol(node) == g.endMarker);
+    }
+
+    // { x y truncated to k : x in a, y in b }
+    TupleSet concat(const TupleSet &a, const TupleSet &b) {
+        TupleSet out;
+        for (int x : a) {
+            if (complete(x)) {
+                out.push_back(x);
+                continue;
+            }
+            for (int y : b) {
+                int node = x;
+                for (int t : trie.symbols(y)) {
+                    if (complete(node)) break;
+                    node = trie.extend(node, t);
+                }
+                out.push_back(node);
+            }
+        }
+        sort(out.begin(), out.end());
+        out.erase(unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    // FIRST_k of a symbol sequence
+    TupleSet firstOf(const int *begin, const int *end) {
+        TupleSet out = {0};
+        for (const int *s = begin; s != end; s++) {
+            if (all_of(out.begin(), out.end(), [&](int x) { return complete(x); })) break;
+            if (g.isTerminal(*s)) {
+                int t = trie.extend(0, *s);
+                out = concat(out, {t});
+            } else {
+                out = concat(out, first[g.row(*s)]);
+            }
+        }
+        return out;
+    }
+
+    // Production number predicted for nonterminal a on lookahead tuple node, 0 if none
+    int predict(int a, int node) const {
+        auto it = table.find(key(g.row(a), node));
+        return it == table.end() ? 0 : it->second;
+    }
+
+    string tupleString(int node) const {
+        string s;
+        for (int t : trie.symbols(node)) s += (s.empty() ? "" : " ") + g.names[t];
+        return s.empty() ? "#" : s;
+    }
+
+private:
+    static uint64_t key(int row, int node) { return (uint64_t)row << 32 | (uint32_t)node; }
+
+    static bool merge(TupleSet &into, const TupleSet &from) {
+        TupleSet merged;
+        merged.reserve(into.size() + from.size());
+        set_union(into.begin(), into.end(), from.begin(), from.end(), back_inserter(merged));
+        if (merged.size() == into.size()) return false;
+        into.swap(merged);
+        return true;
+    }
+
+    // Round-robin over the productions until no set grows
+    void computeFirstK() {
+        first.assign(g.numNonTerminals(), TupleSet());
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int p = 0; p < g.numProductions(); p++) {
+                TupleSet rhsFirst = firstOf(g.rhs(p), g.rhs(p) + g.rhsLength(p));
+                changed |= merge(first[g.row(g.prodLhs[p])], rhsFirst);
+            }
+        }
+    }
+
+    // For A -> alpha B beta, FOLLOW_k(B) includes FIRST_k(beta) FOLLOW_k(A)
+    void computeFollowK() {
+        follow.assign(g.numNonTerminals(), TupleSet());
+        if (g.start >= 0) follow[g.row(g.start)] = {trie.extend(0, g.endMarker)};
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int p = 0; p < g.numProductions(); p++) {
+                const int *rhs = g.rhs(p), *end = rhs + g.rhsLength(p);
+                int a = g.row(g.prodLhs[p]);
+                for (const int *s = rhs; s != end; s++) {
+                    if (g.isTerminal(*s)) continue;
+                    TupleSet after = concat(firstOf(s + 1, end), follow[a]);
+                    changed |= merge(follow[g.row(*s)], after);
+                }
+            }
+        }
+    }
+
+    void buildTable() {
+        for (int i = 0; i < g.numProductions(); i++) {
+            int p = g.byLhs[i];
+            int a = g.row(g.prodLhs[p]);
+            TupleSet lookahead = concat(firstOf(g.rhs(p), g.rhs(p) + g.rhsLength(p)), follow[a]);
+            for (int node : lookahead) {
+                auto inserted = table.emplace(key(a, node), i + 1);
+                if (!inserted.second) {
+                    conflicts.push_back(g.names[g.prodLhs[p]] + " on " + tupleString(node) + ": " +
+                                        to_string(inserted.first->second) + " and " + to_string(i + 1));
+                }
+            }
+        }
+    }
+};
+
+// Predictive parse of a terminal id sequence (without "$"). Appends the
+// production numbers of the leftmost derivation to derivation; on a
+// syntax error returns false with errorAt set to the offending token index.
+// As in parseLL1With, the stack is capped at LL1_MAX_STACK symbols.
+inline bool parseLLk(LLkAnalysis &ll, const vector<int> &input, vector<int> &derivation, size_t &errorAt) {
+    const Grammar &g = ll.g;
+    vector<int> tokens(input);
+    tokens.push_back(g.endMarker);
+    vector<int> stack = {g.endMarker, g.start};
+    size_t pos = 0;
+
+    while (!stack.empty()) {
+        int top = stack.back();
+        stack.pop_back();
+        if (g.isTerminal(top)) {
+            if (tokens[pos] != top) {
+                errorAt = pos;
+                return false;
+            }
+            pos++;
+            continue;
+        }
+
+        // the next k tokens (fewer at the end of input) as a trie node
+        int node = 0;
+        for (size_t i = pos; i < tokens.size() && !ll.complete(node); i++) {
+            node = ll.trie.find(node, tokens[i]);
+            if (node < 0) break;
+        }
+        int number = node < 0 ? 0 : ll.predict(top, node);
+        if (number == 0) {
+            errorAt = pos;
+            return false;
+        }
+        derivation.push_back(number);
+        int p = g.byLhs[number - 1];
+        if (stack.size() + g.rhsLength(p) > LL1_MAX_STACK) {
+            errorAt = pos;
+            return false;
+        }
+        for (int i = g.rhsLength(p) - 1; i >= 0; i--) stack.push_back(g.rhs(p)[i]);
+    }
+    return pos == tokens.size();
+}
@@ -5,62 +5,51 @@
     #include <set>
     #include <algorithm>
     #include <iomanip>
+    #include "GrammarFile.h"
+    #include "GrammarStats.h"
 
     using namespace std;
 
-    // Structure to represent a pr rule
-    struct Production {
-        char lhs;  // Left-hand side
-        string rhs; // Right-hand side
-        
-        Production(char l, string r) : lhs(l), rhs(r) {}
-    };
-
-    // Structure to represent an LR(0) item
+    // Structure to represent an LR(0) item: production number and dot position
     struct Item {
-        Production pr;
+        int prod;
         int dot;
         
-        Item(Production p, int pos) : pr(p), dot(pos) {}
+        Item(int p, int pos) : prod(p), dot(pos) {}
         
         bool operator<(const Item& other) const {
-            if (pr.lhs != other.pr.lhs)
-                return pr.lhs < other.pr.lhs;
-            if (pr.rhs != other.pr.rhs)
-                return pr.rhs < other.pr.rhs;
+            if (prod != other.prod)
+                return prod < other.prod;
             return dot < other.dot;
         }
         
         bool operator==(const Item& other) const {
-            return pr.lhs == other.pr.lhs &&
-                pr.rhs == other.pr.rhs &&
-                dot == other.dot;
+            return prod == other.prod && dot == other.dot;
         }
     };
 
     class Parser {
     private:
-        vector<Production> productions;
-        char startSymbol;
-        set<char> terminals;
-        set<char> nonTerminals;
+        Grammar g;              // production 0 is the augmented S' -> S
         vector<set<Item>> states;
-        map<pair<int, char>, string> parsingTable;
+        map<set<Item>, int> stateIndex;
+        map<pair<int, int>, string> parsingTable;
+        
+        // Symbol after the dot, or -1 if the dot is at the end
+        int nextSymbol(const Item& item) {
+            if (item.dot >= g.rhsLength(item.prod)) return -1;
+            return g.rhs(item.prod)[item.dot];
+        }
         
     public:
-        Parser(vector<Production> prods, char start) : productions(prods), startSymbol(start) {
-            // Extract terminals and non-terminals
-            for (const auto& prod : productions) {
-                nonTerminals.insert(prod.lhs);
-                for (char c : prod.rhs) {
-                    if (isupper(c)) {
-                        nonTerminals.insert(c);
-                    } else if (c != '#') {  // # represents epsilon
-                        terminals.insert(c);
-                    }
-                }
+        Parser(const vector<string>& productions, const string& startSymbol) {
+            // Augmented grammar: add S' -> S in front of the user's productions
+            GrammarBuilder grammar;
+            grammar.addProduction(startSymbol + "'", {startSymbol});
+            for (const string& line : productions) {
+                grammar.addLine(line);
             }
-            terminals.insert('$');  // End marker
+            g = grammar.build(startSymbol + "'");
             
             // Generate canonical collection of LR(0) items
             generateStates();
@@ -69,49 +58,53 @@
             buildParsingTable();
         }
         
+        // augmented grammar: production 0 is S' -> S; with stats the phases are timed
+        Parser(const Grammar& augmented, PhaseStats* stats = nullptr) : g(augmented) {
+            if (stats) stats->start();
+            generateStates();
+            if (stats) stats->stop("lr0_automaton");
+            buildParsingTable();
+            if (stats) {
+                stats->stop("lr0_table");
+                size_t items = 0;
+                for (const auto& state : states) items += state.size();
+                stats->count("states", states.size());
+                stats->count("items", items);
+            }
+        }
+        
         // Closure operation for LR(0) items
         set<Item> closure(set<Item> I) {
             set<Item> closureSet = I;
-            bool changed;
+            vector<Item> work(I.begin(), I.end());
             
-            do {
-                changed = false;
-                set<Item> newItems;
+            while (!work.empty()) {
+                Item item = work.back();
+                work.pop_back();
                 
-                for (const auto& item : closureSet) {
-                    if (item.dot < item.pr.rhs.length()) {
-                        char nextSymbol = item.pr.rhs[item.dot];
-                        
-                        if (nonTerminals.find(nextSymbol) != nonTerminals.end()) {
-                            // Add all productions for this non-terminal
-                            for (const auto& prod : productions) {
-                                if (prod.lhs == nextSymbol) {
-                                    Item newItem(prod, 0);
-                                    if (closureSet.find(newItem) == closureSet.end() && 
-                                        newItems.find(newItem) == newItems.end()) {
-                                        newItems.insert(newItem);
-                                        changed = true;
-                                    }
-                                }
-                            }
+                int next = nextSymbol(item);
+                if (next >= 0 && !g.isTerminal(next)) {
+                    // Add all productions for this non-terminal
+                    int r = g.row(next);
+                    for (int k = g.lhsStart[r]; k < g.lhsStart[r + 1]; k++) {
+                        Item newItem(g.byLhs[k], 0);
+                        if (closureSet.insert(newItem).second) {
+                            work.push_back(newItem);
                         }
                     }
                 }
-                
-                closureSet.insert(newItems.begin(), newItems.end());
-            } while (changed);
+            }
             
             return closureSet;
         }
         
         // Goto operation for LR(0) items
-        set<Item> gotoSet(const set<Item>& I, char X) {
+        set<Item> gotoSet(const set<Item>& I, int X) {
             set<Item> gotoSet;
             
             for (const auto& item : I) {
-                if (item.dot < item.pr.rhs.length() && 
-                    item.pr.rhs[item.dot] == X) {
-                    gotoSet.insert(Item(item.pr, item.dot + 1));
+                if (nextSymbol(item) == X) {
+                    gotoSet.insert(Item(item.prod, item.dot + 1));
                 }
             }
             
@@ -120,108 +113,61 @@
         
         // Generate all states (canonical collection)
         void generateStates() {
-            // Augmented grammar: add S' -> S
-            Production augmentedProd('S', string(1, startSymbol));
-            set<Item> startItems = {Item(augmentedProd, 0)};
+            set<Item> startItems = {Item(0, 0)};
             
             states.push_back(closure(startItems));
+            stateIndex[states[0]] = 0;
             
-            bool changed;
-            do {
-                changed = false;
-                size_t currentSize = states.size();
-                
-                for (size_t i = 0; i < currentSize; i++) {
-                    // Check for transitions on all symbols
-                    for (char symbol : terminals) {
-                        if (symbol == '$') continue; // Skip end marker for goto
-                        
-                        auto newState = gotoSet(states[i], symbol);
-                        if (!newState.empty() && 
-                            find(states.begin(), states.end(), newState) == states.end()) {
-                            states.push_back(newState);
-                            changed = true;
-                        }
-                    }
+            for (size_t i = 0; i < states.size(); i++) {
+                // Check for transitions on all symbols (terminals first, then non-terminals)
+                for (int symbol = 0; symbol < g.numSymbols(); symbol++) {
+                    if (symbol == g.endMarker || symbol == g.epsilon) continue; // Skip end marker for goto
                     
-                    for (char symbol : nonTerminals) {
-                        auto newState = gotoSet(states[i], symbol);
-                        if (!newState.empty() && 
-                            find(states.begin(), states.end(), newState) == states.end()) {
-                            states.push_back(newState);
-                            changed = true;
-                        }
+                    auto newState = gotoSet(states[i], symbol);
+                    if (!newState.empty() && stateIndex.find(newState) == stateIndex.end()) {
+                        stateIndex[newState] = states.size();
+                        states.push_back(newState);
                     }
                 }
-            } while (changed);
+            }
         }
         
         // Build the parsing table
         void buildParsingTable() {
             // Initialize table with "error"
-            for (size_t i = 0; i < states.size(); i++) {
-                for (char term : terminals) {
-                    parsingTable[{i, term}] = "error";
-                }
-                for (char nonTerm : nonTerminals) {
-                    parsingTable[{i, nonTerm}] = "error";
+            for (int i = 0; i < states.size(); i++) {
+                for (int sym = 0; sym < g.numSymbols(); sym++) {
+                    parsingTable[{i, sym}] = "error";
                 }
             }
             
             // Fill the table
-            for (size_t i = 0; i < states.size(); i++) {
-                // Check for shift actions
-                for (char term : terminals) {
-                    if (term == '$') continue;
+            for (int i = 0; i < states.size(); i++) {
+                // Check for shift and goto actions
+                for (int sym = 0; sym < g.numSymbols(); sym++) {
+                    if (sym == g.endMarker || sym == g.epsilon) continue;
                     
-                    auto newState = gotoSet(states[i], term);
+                    auto newState = gotoSet(states[i], sym);
                     if (!newState.empty()) {
-                        auto it = find(states.begin(), states.end(), newState);
-                        if (it != states.end()) {
-                            size_t j = distance(states.begin(), it);
-                            parsingTable[{i, term}] = "s" + to_string(j);
-                        }
+                        int j = stateIndex[newState];
+                        parsingTable[{i, sym}] = g.isTerminal(sym) ? "s" + to_string(j) : to_string(j);
                     }
                 }
                 
                 // Check for reduce actions
                 for (const auto& item : states[i]) {
-                    if (item.dot == item.pr.rhs.length()) {
+                    if (item.dot == g.rhsLength(item.prod)) {
                         // Reduction item
-                        if (item.pr.lhs == 'S' && item.pr.rhs == string(1, startSymbol)) {
+                        if (item.prod == 0) {
                             // Accept action
-                            parsingTable[{i, '$'}] = "acc";
+                            parsingTable[{i, g.endMarker}] = "acc";
                         } else {
-                            // Find pr number
-                            int prodNum = -1;
-                            for (size_t k = 0; k < productions.size(); k++) {
-                                if (productions[k].lhs == item.pr.lhs && 
-                                    productions[k].rhs == item.pr.rhs) {
-                                    prodNum = k;
-                                    break;
-                                }
-                            }
-                            
-                            if (prodNum != -1) {
-                                for (char term : terminals) {
-                                    parsingTable[{i, term}] = "r" + to_string(prodNum);
-                                }
+                            for (int term = 0; term < g.numTerminals; term++) {
+                                if (term != g.epsilon) parsingTable[{i, term}] = "r" + to_string(item.prod);
                             }
                         }
                     }
                 }
-                
-                // Check for goto actions
-                for (char nonTerm : nonTerminals) {
-                    auto newState = gotoSet(states[i], nonTerm);
-                    if (!newState.empty()) {
-                        auto it = find(states.begin(), states.end(), newState);
-                        if (it != states.end()) {
-                            size_t j = distance(states.begin(), it);
-                            parsingTable[{i, nonTerm}] = to_string(j);
-                        }
-                    }
-                }
             }
         }
         
@@ -232,12 +178,13 @@
             
             // Header row
             cout << setw(8) << "State";
-            vector<char> allSymbols;
-            for (char term : terminals) allSymbols.push_back(term);
-            for (char nonTerm : nonTerminals) allSymbols.push_back(nonTerm);
+            vector<int> allSymbols;
+            for (int sym = 0; sym < g.numSymbols(); sym++) {
+                if (sym != g.epsilon && sym != g.start) allSymbols.push_back(sym);
+            }
             
-            for (char sym : allSymbols) {
-                cout << setw(8) << sym;
+            for (int sym : allSymbols) {
+                cout << setw(8) << g.names[sym];
             }
             cout << endl;
             
@@ -247,8 +194,8 @@
             for (size_t i = 0; i < states.size(); i++) {
                 cout << setw(8) << i;
                 
-                for (char sym : allSymbols) {
-                    string action = parsingTable[{i, sym}];
+                for (int sym : allSymbols) {
+                    string action = parsingTable[{(int)i, sym}];
                     cout << setw(8) << action;
                 }
                 cout << endl;
@@ -259,8 +206,8 @@
         void displayGrammar() {
             cout << "GRAMMAR:\n";
             cout << "========\n";
-            for (size_t i = 0; i < productions.size(); i++) {
-                cout << "(" << i << ") " << productions[i].lhs << " -> " << productions[i].rhs << endl;
+            for (int i = 0; i < g.numProductions(); i++) {
+                cout << "(" << i << ") " << productionString(g, i) << endl;
             }
             cout << endl;
         }
@@ -272,37 +219,60 @@
             for (size_t i = 0; i < states.size(); i++) {
                 cout << "I" << i << ":\n";
                 for (const auto& item : states[i]) {
-                    cout << "  " << item.pr.lhs << " -> ";
-                    for (int j = 0; j < item.pr.rhs.length(); j++) {
-                        if (j == item.dot) cout << ".";
-                        cout << item.pr.rhs[j];
-                    }
-                    if (item.dot == item.pr.rhs.length()) cout << ".";
-                    cout << endl;
+                    cout << "  " << itemString(g, item.prod, item.dot) << endl;
                 }
                 cout << endl;
             }
         }
     };
 
-    int main() {
+    int main(int argc, char *argv[]) {
+        // --grammar file analyses a grammar file instead of the example (see GrammarFile.h)
+        // --stats prints phase timings instead of the tables (see GrammarStats.h)
+        const char *grammarFile = nullptr;
+        bool stats = false;
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--grammar" && i + 1 < argc) grammarFile = argv[++i];
+            else if (arg == "--stats") stats = true;
+        }
+        
+        if (grammarFile) {
+            Grammar g;
+            string error;
+            if (!loadGrammarFile(grammarFile, g, error, true)) {
+                cerr << error << "\n";
+                return 1;
+            }
+            PhaseStats phases;
+            if (stats) countGrammar(phases, g);
+            Parser parser(g, stats ? &phases : nullptr);
+            if (stats) {
+                phases.print();
+                return 0;
+            }
+            parser.displayGrammar();
+            parser.displayStates();
+            parser.displayParsingTable();
+            return 0;
+        }
+        
         // Example grammar: E -> E + T | T, T -> T * F | F, F -> (E) | id
-        // vector<Production> productions = {
-        //     Production('E', "E+T"),
-        //     Production('E', "T"),
-        //     Production('T', "T*F"),
-        //     Production('T', "F"),
-        //     Production('F', "(E)"),
-        //     Production('F', "id")
+        // vector<string> productions = {
+        //     "E -> E + T | T",
+        //     "T -> T * F | F",
+        //     "F -> ( E ) | id"
         // };
-        vector<Production> productions = {
-            Production('S', "AB"),
-            Production('A', "a"),
-            Production('B', "b")           
+        vector<string> productions = {
+            "S->AB",
+            "A->a",
+            "B->b"
         };
         
-        char startSymbol = 'S';
+        string startSymbol = "S";
         
+        // the augmented S' -> S is production 0, so S -> AB reduces as r1 (it was r0
+        // before the tools shared Grammar, when the start state held S -> .S instead)
         Parser parser(productions, startSymbol);
         
         // Display information
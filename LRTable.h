@@ -0,0 +1,197 @@
+#pragma once
+
+#include "CombTable.h"
+#include "GrammarStats.h"
+#include "LL1Parser.h"
+
+// Integer ACTION/GOTO arrays compiled from an LR tool's table maps, and a
+// table-driven LR parser over them (SLR, CLR and LALR --compress).
+//
+// action[state * numTerminals + terminal] is 0 for an error, s + 1 to shift
+// to state s, and -(p + 1) to reduce by production p; reducing by the
+// augmented production 0 accepts. go[state * numNonTerminals + row] is the
+// target state, or -1.
+struct LRTables {
+    int numStates = 0;
+    int numTerminals = 0;
+    int numNonTerminals = 0;
+    vector<int32_t> action;
+    vector<int32_t> go;
+    vector<int32_t> prodRow;        // row of each production's left-hand side
+    vector<int32_t> prodLength;
+};
+
+// Sets ACTION cell (state, terminal) of the tools' table map. A cell that
+// already holds a different action is a shift/reduce or reduce/reduce
+// conflict, recorded in conflicts and resolved as yacc does: a shift (or
+// accept) beats a reduction, and the lower-numbered production wins.
+inline void setAction(const Grammar &g, map<pair<int, int>, string> &actionTable, vector<string> &conflicts, int state,
+                      int terminal, const string &action) {
+    auto inserted = actionTable.emplace(make_pair(state, terminal), action);
+    string &cell = inserted.first->second;
+    if (inserted.second || cell == action) return;
+    string conflict = "state " + to_string(state) + " on " + g.names[terminal] + ": " + min(cell, action) + " and " +
+                      max(cell, action);
+    if (find(conflicts.begin(), conflicts.end(), conflict) == conflicts.end()) conflicts.push_back(conflict);
+    if (cell[0] == 'r' && (action[0] != 'r' || stoi(action.substr(1)) < stoi(cell.substr(1)))) cell = action;
+}
+
+// Prints the conflicts setAction recorded, as "Grammar is NOT <kind>" and one per line
+inline void printLRConflicts(ostream &out, const char *kind, const vector<string> &conflicts) {
+    out << "Grammar is NOT " << kind << " (" << conflicts.size() << " conflicts):\n";
+    for (const string &c : conflicts) out << "  " << c << "\n";
+}
+
+// Action strings as the tools store them: "s<state>", "r<production>" or "acc"
+inline LRTables compileLR(const Grammar &g, int numStates, const map<pair<int, int>, string> &actionTable,
+                          const map<pair<int, int>, int> &gotoTable) {
+    LRTables t;
+    t.numStates = numStates;
+    t.numTerminals = g.numTerminals;
+    t.numNonTerminals = g.numNonTerminals();
+    t.action.assign((size_t)numStates * t.numTerminals, 0);
+    t.go.assign((size_t)numStates * t.numNonTerminals, -1);
+    for (auto &a : actionTable) {
+        int32_t &cell = t.action[(size_t)a.first.first * t.numTerminals + a.first.second];
+        const string &s = a.second;
+        if (s == "acc") cell = -1;
+        else if (s[0] == 's') cell = stoi(s.substr(1)) + 1;
+        else if (s[0] == 'r') cell = -(stoi(s.substr(1)) + 1);
+    }
+    for (auto &e : gotoTable) t.go[(size_t)e.first.first * t.numNonTerminals + g.row(e.first.second)] = e.second;
+    for (int p = 0; p < g.numProductions(); p++) {
+        t.prodRow.push_back(g.row(g.prodLhs[p]));
+        t.prodLength.push_back(g.rhsLength(p));
+    }
+    return t;
+}
+
+// Parses tokens[0 .. n), which must end with "$". action(state, terminal)
+// and go(state, row) read the tables, so the same driver runs over the
+// dense arrays or comb-vector copies of them. On a syntax error returns
+// false with errorAt set to the offending token index. The stack is capped
+// at LL1_MAX_STACK states, past which the parse fails at the current token.
+template <class Action, class Goto>
+bool parseLR(const LRTables &t, Action action, Goto go, const int32_t *tokens, size_t n, size_t &errorAt) {
+    const int32_t *length = t.prodLength.data();
+    const int32_t *lhsRow = t.prodRow.data();
+    vector<int32_t> stack(1024);
+    size_t sp = 0, pos = 0;
+    stack[sp++] = 0;
+    for (;;) {
+        int32_t a = pos < n ? action(stack[sp - 1], tokens[pos]) : 0;
+        if (sp == stack.size()) {
+            if (sp == LL1_MAX_STACK) break;
+            stack.resize(min(2 * sp, LL1_MAX_STACK));
+        }
+        if (a > 0) {
+            stack[sp++] = a - 1;
+            pos++;
+            continue;
+        }
+        if (a < 0 && a != -1) {
+            int p = -a - 1;
+            sp -= length[p];
+            int32_t target = go(stack[sp - 1], lhsRow[p]);
+            if (target >= 0) {
+                stack[sp++] = target;
+                continue;
+            }
+        }
+        // a default reduction may stand in for an error, so check acceptance is on "$"
+        if (a == -1 && pos + 1 == n) return true;
+        break;
+    }
+    errorAt = pos;
+    return false;
+}
+
+// Reports the dense and comb-vector table sizes and, for benchTokens > 0,
+// parse rates over a generated sentence of about that many tokens. Returns
+// false if no such sentence could be generated.
+inline bool reportLRCompression(const Grammar &g, const LRTables &t, size_t benchTokens, PhaseStats *stats) {
+    auto action = compressTable<int32_t>(t.action.data(), t.numStates, t.numTerminals, 0, false);
+    auto go = compressTable<int32_t>(t.go.data(), t.numStates, t.numNonTerminals, -1, false);
+    // only a reduction may become a row's default (see CombTable.h)
+    auto actionElided = compressTable<int32_t>(t.action.data(), t.numStates, t.numTerminals, 0, true,
+                                               [](int32_t a) { return a < -1; });
+    auto goElided = compressTable<int32_t>(t.go.data(), t.numStates, t.numNonTerminals, -1, true);
+    size_t dense = (t.action.size() + t.go.size()) * sizeof(int32_t);
+    size_t comb = action.bytes() + go.bytes();
+    size_t elided = actionElided.bytes() + goElided.bytes();
+    if (stats) {
+        stats->count("dense_bytes", dense);
+        stats->count("comb_bytes", comb);
+        stats->count("comb_default_bytes", elided);
+    } else {
+        cout << "Dense tables:          " << dense << " bytes\n"
+             << "Comb vectors:          " << comb << " bytes (" << (double)dense / comb << "x smaller)\n"
+             << "Comb vectors, default: " << elided << " bytes (" << (double)dense / elided << "x smaller)\n";
+    }
+    if (benchTokens == 0) return true;
+
+    mt19937 rng(12345);
+    vector<int32_t> tokens;
+    if (!generateSentence(g, rng, benchTokens, tokens)) {
+        cerr << "Cannot generate a sentence of about " << benchTokens << " tokens (got " << tokens.size() << ")\n";
+        return false;
+    }
+    tokens.push_back(g.endMarker);
+    size_t count = tokens.size() - 1;
+
+    // best of 5, so page faults on the first run are taken out
+    auto rate = [&](auto actionAt, auto goAt, bool &ok) {
+        double best = -1;
+        size_t errorAt = 0;
+        for (int r = 0; r < 5; r++) {
+            auto begin = chrono::steady_clock::now();
+            ok = parseLR(t, actionAt, goAt, tokens.data(), tokens.size(), errorAt);
+            double secs = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+            if (best < 0 || secs < best) best = secs;
+        }
+        return (long long)(count / best);
+    };
+    const int32_t *denseAction = t.action.data(), *denseGo = t.go.data();
+    int terminals = t.numTerminals, nonTerminals = t.numNonTerminals;
+    bool ok = false, combOk = false, elidedOk = false;
+    long long denseRate = rate([=](int s, int32_t x) { return denseAction[(size_t)s * terminals + x]; },
+                               [=](int s, int r) { return denseGo[(size_t)s * nonTerminals + r]; }, ok);
+    long long combRate = rate([&](int s, int32_t x) { return action.at(s, x); },
+                              [&](int s, int r) { return go.at(s, r); }, combOk);
+    long long elidedRate = rate([&](int s, int32_t x) { return actionElided.at(s, x); },
+                                [&](int s, int r) { return goElided.at(s, r); }, elidedOk);
+
+    // the compressed tables must reject exactly what the dense ones reject, at the same token
+    const int TRIALS = 500;
+    vector<int32_t> shortSentence;
+    generateSentence(g, rng, min<size_t>(benchTokens, 1000), shortSentence);
+    shortSentence.push_back(g.endMarker);
+    auto parser = [&](auto actionAt, auto goAt) {
+        return [=, &t](const vector<int32_t> &input, size_t &errorAt) {
+            return parseLR(t, actionAt, goAt, input.data(), input.size(), errorAt);
+        };
+    };
+    size_t mismatches = countDisagreements(
+        g, rng, shortSentence, TRIALS,
+        {parser([=](int s, int32_t x) { return denseAction[(size_t)s * terminals + x]; },
+                [=](int s, int r) { return denseGo[(size_t)s * nonTerminals + r]; }),
+         parser([&](int s, int32_t x) { return action.at(s, x); }, [&](int s, int r) { return go.at(s, r); }),
+         parser([&](int s, int32_t x) { return actionElided.at(s, x); },
+                [&](int s, int r) { return goElided.at(s, r); })});
+
+    if (stats) {
+        stats->count("tokens", count);
+        stats->count("accepted", ok && combOk && elidedOk);
+        stats->count("tokens_per_sec", denseRate);
+        stats->count("comb_tokens_per_sec", combRate);
+        stats->count("comb_default_tokens_per_sec", elidedRate);
+        stats->count("reject_mismatches", mismatches);
+        return true;
+    }
+    cout << (ok && combOk && elidedOk ? "Accepted " : "Rejected ") << count << " tokens\n"
+         << "Dense tables:          " << count << " tokens, " << denseRate << " tokens/sec\n"
+         << "Comb vectors:          " << count << " tokens, " << combRate << " tokens/sec\n"
+         << "Comb vectors, default: " << count << " tokens, " << elidedRate << " tokens/sec\n"
+         << "Mutated inputs:        " << TRIALS << " checked, " << mismatches << " parsed differently\n";
+    return true;
+}
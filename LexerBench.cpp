@@ -0,0 +1,260 @@
+#include <bits/stdc++.h>
+using namespace std;
+
+// Lexer throughput benchmark
+//
+// Generates a synthetic C-like corpus and times the lexers on it:
+//   DifferentTokens --count <corpus>
+//   NFA --batch <token-per-line corpus>
+//   flex scanner built from the spec embedded in Lexer.txt (if flex is installed),
+//   with its printf actions replaced by a token counter so it does the same work as --count
+//
+// Each lexer's own token count is reported, and a warning is printed when it
+// differs from the number of tokens the generator wrote.
+//
+// Build DifferentTokens and NFA in the current directory first, then run
+//   LexerBench [--size MB] [--mix keyword|identifier|number|whitespace|balanced|all]
+//              [--repeat N] [--json] [--bin-dir DIR] [--spec Lexer.txt]
+// Results are written to stdout as CSV (default) or JSON.
+
+struct Mix {
+    string name;
+    // relative weights of keyword, identifier, number, operator/separator tokens
+    int keyword, identifier, number, punct;
+    // average number of extra whitespace bytes between tokens
+    int whitespace;
+};
+
+vector<Mix> mixes = {
+    {"balanced",   2, 4, 2, 3, 1},
+    {"keyword",    8, 1, 1, 1, 1},
+    {"identifier", 1, 8, 1, 1, 1},
+    {"number",     1, 1, 8, 1, 1},
+    {"whitespace", 2, 4, 2, 3, 24},
+};
+
+// Tokens every lexer splits the same way when separated by whitespace
+const vector<string> keywords = {"int", "float", "if", "else", "while", "return"};
+const vector<string> punct = {"+", "-", "*", "/", "=", ";", ",", "(", ")"};
+
+struct Corpus {
+    string text;            // whitespace separated source
+    string tokenLines;      // same tokens one per line (NFA batch input)
+    size_t tokens = 0;
+};
+
+Corpus generate(const Mix &mix, size_t bytes, unsigned seed) {
+    Corpus c;
+    mt19937 rng(seed);
+    int total = mix.keyword + mix.identifier + mix.number + mix.punct;
+    const char *letters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const char *alnum = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+    c.text.reserve(bytes + 64);
+    while (c.text.size() < bytes) {
+        int r = rng() % total;
+        string tok;
+        if (r < mix.keyword) {
+            tok = keywords[rng() % keywords.size()];
+        } else if (r < mix.keyword + mix.identifier) {
+            tok += letters[rng() % 52];
+            int len = rng() % 12;
+            for (int k = 0; k < len; k++) tok += alnum[rng() % 36];
+            // keep identifiers from spelling a keyword
+            if (find(keywords.begin(), keywords.end(), tok) != keywords.end()) tok += 'x';
+        } else if (r < mix.keyword + mix.identifier + mix.number) {
+            int len = 1 + rng() % 8;
+            for (int k = 0; k < len; k++) tok += char('0' + rng() % 10);
+        } else {
+            tok = punct[rng() % punct.size()];
+        }
+
+        c.text += tok;
+        c.tokenLines += tok;
+        c.tokenLines += '\n';
+        c.tokens++;
+
+        // one mandatory separator, plus extra whitespace for whitespace-heavy mixes
+        c.text += (rng() % 8 == 0) ? '\n' : ' ';
+        int extra = mix.whitespace > 1 ? rng() % (2 * mix.whitespace) : 0;
+        for (int k = 0; k < extra; k++) c.text += (k % 8 == 7) ? '\t' : ' ';
+    }
+    return c;
+}
+
+bool writeFile(const string &path, const string &data) {
+    ofstream out(path, ios::binary);
+    out.write(data.data(), data.size());
+    return (bool)out;
+}
+
+bool fileExists(const string &path) {
+    return ifstream(path).good();
+}
+
+// Runs a shell command and returns wall time in seconds (negative on failure)
+double timeCommand(const string &cmd) {
+    auto start = chrono::steady_clock::now();
+    int status = system(cmd.c_str());
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return status == 0 ? secs : -1;
+}
+
+// Pulls the lex program out of Lexer.txt (from "%{" to the end of yywrap) and
+// builds it. The per-token printf actions become a counter, and main prints
+// the count at the end, like DifferentTokens --count.
+string buildFlexScanner(const string &specPath, const string &dir) {
+    ifstream in(specPath);
+    if (!in) return "";
+    string line, spec;
+    bool inside = false, inYywrap = false, declared = false;
+    int sections = 0;       // "%%" lines seen
+    while (getline(in, line)) {
+        if (!inside && line.rfind("%{", 0) == 0) inside = true;
+        if (!inside) continue;
+        if (!declared && line.rfind("%}", 0) == 0) {
+            spec += "static size_t tokens = 0;\n";
+            declared = true;
+        }
+        if (line.rfind("%%", 0) == 0) sections++;
+        size_t action = line.find('{', line.find_first_of(" \t"));
+        if (sections == 1 && line.find("printf(") != string::npos && action != string::npos) {
+            line = line.substr(0, action) + "{ tokens++; }";
+        }
+        spec += line + "\n";
+        if (sections == 2 && line.find("yylex();") != string::npos) spec += "    printf(\"%zu\\n\", tokens);\n";
+        if (line.find("int yywrap") != string::npos) inYywrap = true;
+        else if (inYywrap && line.find('}') != string::npos) break;
+    }
+    if (spec.empty() || !declared) return "";
+
+    string lexFile = dir + "/bench_lexer.l";
+    string binary = dir + "/bench_flex_lexer";
+    if (!writeFile(lexFile, spec)) return "";
+    string cmd = "cd " + dir + " && flex -o bench_lex.yy.c bench_lexer.l >/dev/null 2>&1"
+                 " && gcc -O2 bench_lex.yy.c -o bench_flex_lexer >/dev/null 2>&1";
+    if (system(cmd.c_str()) != 0) return "";
+    return binary;
+}
+
+// The token count a lexer wrote to path: the number after prefix on the
+// first line that starts with it, or -1
+long long readTokenCount(const string &path, const string &prefix) {
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        if (line.rfind(prefix, 0) == 0) return atoll(line.c_str() + prefix.size());
+    }
+    return -1;
+}
+
+struct Result {
+    string mix, lexer;
+    size_t bytes, tokens;
+    double seconds;
+};
+
+int main(int argc, char *argv[]) {
+    double sizeMB = 64;
+    string mixName = "all";
+    int repeat = 3;
+    bool json = false;
+    string binDir = ".";
+    string specPath = "Lexer.txt";
+
+    for (int a = 1; a < argc; a++) {
+        string arg = argv[a];
+        auto value = [&]() { return a + 1 < argc ? string(argv[++a]) : string(); };
+        if (arg == "--size") sizeMB = atof(value().c_str());
+        else if (arg == "--mix") mixName = value();
+        else if (arg == "--repeat") repeat = max(1, atoi(value().c_str()));
+        else if (arg == "--json") json = true;
+        else if (arg == "--bin-dir") binDir = value();
+        else if (arg == "--spec") specPath = value();
+        else {
+            cerr << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+
+    string dir = "/tmp";
+    if (const char *tmp = getenv("TMPDIR")) dir = tmp;
+
+    string tokensBin = binDir + "/DifferentTokens";
+    string nfaBin = binDir + "/NFA";
+    if (!fileExists(tokensBin)) cerr << "Skipping DifferentTokens: " << tokensBin << " not found\n";
+    if (!fileExists(nfaBin)) cerr << "Skipping NFA: " << nfaBin << " not found\n";
+    string flexBin = buildFlexScanner(specPath, dir);
+    if (flexBin.empty()) cerr << "Skipping flex: could not build a scanner from " << specPath << "\n";
+
+    vector<Result> results;
+    for (const Mix &mix : mixes) {
+        if (mixName != "all" && mixName != mix.name) continue;
+
+        Corpus corpus = generate(mix, (size_t)(sizeMB * 1024 * 1024), 12345);
+        string corpusPath = dir + "/bench_corpus_" + mix.name + ".c";
+        string linesPath = dir + "/bench_tokens_" + mix.name + ".txt";
+        writeFile(corpusPath, corpus.text);
+        writeFile(linesPath, corpus.tokenLines);
+
+        // name, command, and how the lexer reports its token count (written to countPath)
+        struct Command {
+            string lexer, cmd, countPrefix;
+        };
+        string countPath = dir + "/bench_count_" + mix.name + ".txt";
+        vector<Command> commands;
+        if (fileExists(tokensBin))
+            commands.push_back({"DifferentTokens", tokensBin + " --count " + corpusPath + " >" + countPath, ""});
+        if (fileExists(nfaBin))
+            commands.push_back({"NFA", nfaBin + " --batch " + linesPath + " >/dev/null 2>" + countPath, "Tokens: "});
+        if (!flexBin.empty())
+            commands.push_back({"flex", flexBin + " < " + corpusPath + " >" + countPath, ""});
+
+        for (auto &cmd : commands) {
+            // best of N runs, so page cache and startup noise are taken out
+            double best = -1;
+            for (int r = 0; r < repeat; r++) {
+                double t = timeCommand(cmd.cmd);
+                if (t >= 0 && (best < 0 || t < best)) best = t;
+            }
+            long long tokens = readTokenCount(countPath, cmd.countPrefix);
+            if (best < 0 || tokens < 0) {
+                cerr << cmd.lexer << " failed on " << mix.name << "\n";
+                continue;
+            }
+            if ((size_t)tokens != corpus.tokens) {
+                cerr << "Warning: " << cmd.lexer << " counted " << tokens << " tokens on " << mix.name
+                     << ", the corpus has " << corpus.tokens << "\n";
+            }
+            size_t bytes = cmd.lexer == "NFA" ? corpus.tokenLines.size() : corpus.text.size();
+            results.push_back({mix.name, cmd.lexer, bytes, (size_t)tokens, best});
+        }
+
+        remove(countPath.c_str());
+        remove(corpusPath.c_str());
+        remove(linesPath.c_str());
+    }
+
+    if (json) {
+        cout << "[\n";
+        for (int i = 0; i < results.size(); i++) {
+            const Result &r = results[i];
+            cout << "  {\"mix\": \"" << r.mix << "\", \"lexer\": \"" << r.lexer
+                 << "\", \"bytes\": " << r.bytes << ", \"tokens\": " << r.tokens
+                 << ", \"seconds\": " << r.seconds
+                 << ", \"tokens_per_sec\": " << (size_t)(r.tokens / r.seconds)
+                 << ", \"bytes_per_sec\": " << (size_t)(r.bytes / r.seconds) << "}"
+                 << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        cout << "]\n";
+    } else {
+        cout << "mix,lexer,bytes,tokens,seconds,tokens_per_sec,bytes_per_sec\n";
+        for (const Result &r : results) {
+            cout << r.mix << "," << r.lexer << "," << r.bytes << "," << r.tokens << ","
+                 << r.seconds << "," << (size_t)(r.tokens / r.seconds) << ","
+                 << (size_t)(r.bytes / r.seconds) << "\n";
+        }
+    }
+
+    return 0;
+}
@@ -1,51 +1,449 @@
 #include <iostream>
 #include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
 using namespace std;
 
-bool isIdentifier(const string &s) {
-    // NFA start state
-    int i = 0;
+// ---------------- Compile-time regex -> DFA ----------------
+//
+// static_regex<Pattern> turns a regex into a DFA table during compilation
+// (Glushkov position automaton + subset construction), so matching is a
+// table walk with no construction at run time.
+// Supports literals, escapes, [...] classes with ranges and ^, '.' (any byte but
+// newline), (), |, *, + and ?.
 
-    // First character must be letter or underscore
-    if (!(isalpha(s[i]) || s[i] == '_'))
-        return false;
+const int MAX_POSITIONS = 64;
+const int MAX_DFA_STATES = 64;
 
-    // Remaining characters
-    i++;
-    while (i < s.length()) {
-        if (!(isalnum(s[i]) || s[i] == '_'))
-            return false;
-        i++;
+struct CharSet {
+    uint64_t w[4] = {0, 0, 0, 0};
+
+    constexpr void add(unsigned char c) { w[c >> 6] |= 1ULL << (c & 63); }
+    constexpr bool has(unsigned char c) const { return (w[c >> 6] >> (c & 63)) & 1; }
+
+    constexpr void addRange(unsigned char lo, unsigned char hi) {
+        for (int c = lo; c <= hi; c++) add(c);
+    }
+
+    constexpr void invert() {
+        for (auto &x : w) x = ~x;
+    }
+};
+
+// Positions of the regex with their character sets and FOLLOW sets
+struct Glushkov {
+    CharSet chars[MAX_POSITIONS] = {};
+    uint64_t follow[MAX_POSITIONS] = {};
+    int count = 0;
+};
+
+// nullable/first/last of a sub-expression, sets are position bitmasks
+struct RegexPart {
+    bool nullable;
+    uint64_t first, last;
+};
+
+class RegexCompiler {
+private:
+    const char *re;
+    int pos = 0;
+
+    constexpr char peek() const { return re[pos]; }
+
+    constexpr char escaped(char c) const {
+        if (c == 'n') return '\n';
+        if (c == 't') return '\t';
+        if (c == 'r') return '\r';
+        return c;
+    }
+
+    constexpr RegexPart position(const CharSet &set) {
+        if (g.count == MAX_POSITIONS) throw "regex has too many positions";
+        g.chars[g.count] = set;
+        uint64_t bit = 1ULL << g.count++;
+        return {false, bit, bit};
+    }
+
+    constexpr void addFollow(uint64_t from, uint64_t to) {
+        for (int p = 0; p < g.count; p++)
+            if ((from >> p) & 1) g.follow[p] |= to;
+    }
+
+    constexpr RegexPart atom() {
+        CharSet set;
+        char c = re[pos++];
+        if (c == '(') {
+            RegexPart inner = alternation();
+            pos++;  // ')'
+            return inner;
+        }
+        if (c == '[') {
+            bool negate = peek() == '^';
+            if (negate) pos++;
+            while (peek() && peek() != ']') {
+                char lo = re[pos++];
+                if (lo == '\\') lo = escaped(re[pos++]);
+                char hi = lo;
+                if (peek() == '-' && re[pos + 1] != ']' && re[pos + 1]) {
+                    pos++;
+                    hi = re[pos++];
+                    if (hi == '\\') hi = escaped(re[pos++]);
+                }
+                set.addRange(lo, hi);
+            }
+            pos++;  // ']'
+            if (negate) set.invert();
+            return position(set);
+        }
+        if (c == '.') {
+            // any byte but newline, as in flex and DFAScanner
+            set.add('\n');
+            set.invert();
+            return position(set);
+        }
+        if (c == '\\') c = escaped(re[pos++]);
+        set.add(c);
+        return position(set);
+    }
+
+    constexpr RegexPart repeat() {
+        RegexPart r = atom();
+        while (peek() == '*' || peek() == '+' || peek() == '?') {
+            char op = re[pos++];
+            if (op != '?') addFollow(r.last, r.first);
+            if (op != '+') r.nullable = true;
+        }
+        return r;
+    }
+
+    constexpr RegexPart concat() {
+        RegexPart r = {true, 0, 0};
+        while (peek() && peek() != '|' && peek() != ')') {
+            RegexPart next = repeat();
+            addFollow(r.last, next.first);
+            r = {r.nullable && next.nullable,
+                 r.nullable ? r.first | next.first : r.first,
+                 next.nullable ? r.last | next.last : next.last};
+        }
+        return r;
+    }
+
+    constexpr RegexPart alternation() {
+        RegexPart r = concat();
+        while (peek() == '|') {
+            pos++;
+            RegexPart other = concat();
+            r = {r.nullable || other.nullable, r.first | other.first, r.last | other.last};
+        }
+        return r;
+    }
+
+public:
+    Glushkov g;
+
+    constexpr RegexCompiler(const char *pattern) : re(pattern) {}
+
+    constexpr RegexPart parse() { return alternation(); }
+};
+
+// State 0 is dead, state 1 is the start state
+struct StaticDFA {
+    int states = 0;
+    int classes = 0;
+    uint8_t byteClass[256] = {};
+    uint8_t next[MAX_DFA_STATES][MAX_POSITIONS + 1] = {};
+    bool accept[MAX_DFA_STATES] = {};
+};
+
+constexpr StaticDFA compileRegex(const char *pattern) {
+    RegexCompiler compiler(pattern);
+    RegexPart whole = compiler.parse();
+    const Glushkov &g = compiler.g;
+    StaticDFA dfa;
+
+    // matches[c] = positions whose class contains c; equal masks share a byte class
+    uint64_t matches[256] = {};
+    uint64_t classMatches[MAX_POSITIONS + 1] = {};
+    for (int c = 0; c < 256; c++) {
+        for (int p = 0; p < g.count; p++)
+            if (g.chars[p].has(c)) matches[c] |= 1ULL << p;
+        int k = 0;
+        while (k < dfa.classes && classMatches[k] != matches[c]) k++;
+        if (k == dfa.classes) {
+            if (k == MAX_POSITIONS + 1) throw "regex has too many byte classes";
+            classMatches[dfa.classes++] = matches[c];
+        }
+        dfa.byteClass[c] = k;
+    }
+
+    // A DFA state is the set of positions that may match next plus an accept flag
+    uint64_t candidates[MAX_DFA_STATES] = {};
+    candidates[1] = whole.first;
+    dfa.accept[1] = whole.nullable;
+    dfa.states = 2;
+
+    for (int s = 1; s < dfa.states; s++) {
+        for (int k = 0; k < dfa.classes; k++) {
+            uint64_t matched = candidates[s] & classMatches[k];
+            uint64_t target = 0;
+            for (int p = 0; p < g.count; p++)
+                if ((matched >> p) & 1) target |= g.follow[p];
+            bool accepting = (matched & whole.last) != 0;
+
+            int t = 0;
+            if (matched) {
+                t = 1;
+                while (t < dfa.states && !(candidates[t] == target && dfa.accept[t] == accepting)) t++;
+                if (t == dfa.states) {
+                    if (dfa.states == MAX_DFA_STATES) throw "regex needs too many DFA states";
+                    candidates[t] = target;
+                    dfa.accept[t] = accepting;
+                    dfa.states++;
+                }
+            }
+            dfa.next[s][k] = t;
+        }
     }
-    return true; // accepting state
+    return dfa;
 }
 
-bool isConstant(const string &s) {
-    int i = 0;
+template <const char *Pattern>
+struct static_regex {
+    static constexpr StaticDFA dfa = compileRegex(Pattern);
 
-    // At least one digit required
-    if (!isdigit(s[i]))
-        return false;
+    // Whole-string match
+    static bool match(string_view s) {
+        int state = 1;
+        for (char c : s) {
+            state = dfa.next[state][dfa.byteClass[(unsigned char)c]];
+            if (state == 0) return false;
+        }
+        return dfa.accept[state];
+    }
+};
+
+// Token automata
+constexpr char identifierPattern[] = "[a-zA-Z_][a-zA-Z0-9_]*";
+constexpr char constantPattern[] = "[0-9]+";
+constexpr char operatorPattern[] = "[-+*/=<>]";
+
+bool isIdentifier(string_view s) {
+    return static_regex<identifierPattern>::match(s);
+}
+
+bool isConstant(string_view s) {
+    return static_regex<constantPattern>::match(s);
+}
+
+bool isOperator(string_view s) {
+    return static_regex<operatorPattern>::match(s);
+}
+
+// Result codes written one per line in batch mode
+enum TokenClass { IDENTIFIER, CONSTANT, OPERATOR, INVALID };
+const char classCodes[] = {'I', 'C', 'O', 'X'};
+const char *classNames[] = {"Identifier", "Constant", "Operator", "Invalid"};
+
+TokenClass classify(string_view token) {
+    if (isIdentifier(token))
+        return IDENTIFIER;
+    if (isConstant(token))
+        return CONSTANT;
+    if (isOperator(token))
+        return OPERATOR;
+    return INVALID;
+}
+
+// ---------------- Bit-parallel Glushkov matcher ----------------
+//
+// All token patterns share one 64-bit word of Glushkov positions. A step is
+// "positions that may come next" AND "positions whose class holds c", and
+// the follow sets of a whole word are looked up one byte of positions at a time.
+class GlushkovMatcher {
+private:
+    uint64_t charMask[256] = {};        // positions whose class contains c
+    uint64_t followTable[8][256] = {};  // union of follow sets for each byte of positions
+    uint64_t first = 0;
+    vector<uint64_t> last;              // accepting positions per pattern
+    vector<TokenClass> classes;
+    int chunks = 0;
+
+    uint64_t follow(uint64_t d) const {
+        uint64_t next = 0;
+        for (int k = 0; k < chunks; k++)
+            next |= followTable[k][(d >> (8 * k)) & 0xff];
+        return next;
+    }
+
+public:
+    // Patterns are tried in order, so list them by priority
+    GlushkovMatcher(const vector<pair<const char *, TokenClass>> &patterns) {
+        int base = 0;
+        uint64_t followOf[MAX_POSITIONS] = {};
+        for (auto &p : patterns) {
+            RegexCompiler compiler(p.first);
+            RegexPart part = compiler.parse();
+            const Glushkov &g = compiler.g;
+            if (base + g.count > MAX_POSITIONS) {
+                cerr << "Too many positions for one word" << endl;
+                exit(1);
+            }
+            for (int q = 0; q < g.count; q++) {
+                followOf[base + q] = g.follow[q] << base;
+                for (int c = 0; c < 256; c++)
+                    if (g.chars[q].has(c)) charMask[c] |= 1ULL << (base + q);
+            }
+            first |= part.first << base;
+            last.push_back(part.last << base);
+            classes.push_back(p.second);
+            base += g.count;
+        }
+
+        chunks = (base + 7) / 8;
+        for (int k = 0; k < chunks; k++)
+            for (int b = 0; b < 256; b++)
+                for (int bit = 0; bit < 8; bit++)
+                    if ((b >> bit) & 1) followTable[k][b] |= followOf[8 * k + bit];
+    }
+
+    TokenClass classify(string_view s) const {
+        if (s.empty()) return INVALID;
+        uint64_t candidates = first, matched = 0;
+        for (char c : s) {
+            matched = candidates & charMask[(unsigned char)c];
+            if (!matched) return INVALID;
+            candidates = follow(matched);
+        }
+        for (int i = 0; i < last.size(); i++)
+            if (matched & last[i]) return classes[i];
+        return INVALID;
+    }
+};
+
+const GlushkovMatcher glushkovTokens({
+    {identifierPattern, IDENTIFIER},
+    {constantPattern, CONSTANT},
+    {operatorPattern, OPERATOR},
+});
 
-    while (i < s.length()) {
-        if (!isdigit(s[i]))
-            return false;
-        i++;
+TokenClass classifyGlushkov(string_view token) {
+    return glushkovTokens.classify(token);
+}
+
+// Times both engines on random short tokens
+void benchEngines() {
+    vector<string> tokens;
+    mt19937 rng(7);
+    const char *alphabet = "abcxyzABC_0123456789+-*/=<>;";
+    for (int i = 0; i < 1000000; i++) {
+        string t;
+        int len = 1 + rng() % 6;
+        for (int k = 0; k < len; k++) t += alphabet[rng() % 28];
+        tokens.push_back(t);
     }
-    return true; // accepting state
+
+    auto run = [&](const char *name, TokenClass (*engine)(string_view)) {
+        long long counts[4] = {0, 0, 0, 0};
+        auto start = chrono::steady_clock::now();
+        for (int round = 0; round < 10; round++)
+            for (const string &t : tokens) counts[engine(t)]++;
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        cout << name << ": " << ns / (10.0 * tokens.size()) << " ns/token (I " << counts[0]
+             << ", C " << counts[1] << ", O " << counts[2] << ", X " << counts[3] << ")\n";
+    };
+
+    run("DFA tables", classify);
+    run("bit-parallel Glushkov", classifyGlushkov);
 }
 
-bool isOperator(const string &s) {
-    if (s.length() != 1)
-        return false;
+// Classifies one token per line from in; writes one result code per line
+// to stdout and a histogram to stderr
+int runBatch(FILE *in, TokenClass (*classifier)(string_view)) {
+    const size_t BLOCK = 1 << 20;
+    static char buf[BLOCK];
+    string out;
+    out.reserve(BLOCK);
+    string partial;     // line split across two reads
+    long long counts[4] = {0, 0, 0, 0};
 
-    char op = s[0];
-    return (op == '+' || op == '-' || op == '*' ||
-            op == '/' || op == '=' || op == '<' ||
-            op == '>');
+    auto handle = [&](string_view line) {
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        TokenClass c = classifier(line);
+        counts[c]++;
+        out += classCodes[c];
+        out += '\n';
+        if (out.size() >= BLOCK) {
+            fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    };
+
+    size_t got;
+    while ((got = fread(buf, 1, BLOCK, in)) > 0) {
+        size_t start = 0;
+        while (start < got) {
+            const char *nl = (const char *)memchr(buf + start, '\n', got - start);
+            if (!nl) {
+                partial.append(buf + start, got - start);
+                break;
+            }
+            size_t end = nl - buf;
+            if (!partial.empty()) {
+                partial.append(buf + start, end - start);
+                handle(partial);
+                partial.clear();
+            } else {
+                handle(string_view(buf + start, end - start));
+            }
+            start = end + 1;
+        }
+    }
+    if (!partial.empty())
+        handle(partial);
+    fwrite(out.data(), 1, out.size(), stdout);
+
+    long long total = counts[0] + counts[1] + counts[2] + counts[3];
+    fprintf(stderr, "Tokens: %lld\n", total);
+    for (int c = 0; c < 4; c++)
+        fprintf(stderr, "%-10s (%c): %lld\n", classNames[c], classCodes[c], counts[c]);
+    return 0;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        benchEngines();
+        return 0;
+    }
+
+    // NFA --batch [--glushkov] [file]: classify a token-per-line file or stdin
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        TokenClass (*classifier)(string_view) = classify;
+        int a = 2;
+        if (a < argc && string(argv[a]) == "--glushkov") {
+            classifier = classifyGlushkov;
+            a++;
+        }
+        FILE *in = stdin;
+        if (a < argc && string(argv[a]) != "-") {
+            in = fopen(argv[a], "rb");
+            if (!in) {
+                cerr << "Cannot open " << argv[a] << endl;
+                return 1;
+            }
+        }
+        int status = runBatch(in, classifier);
+        if (in != stdin)
+            fclose(in);
+        return status;
+    }
+
     string token;
 
     cout << "Enter a token: ";
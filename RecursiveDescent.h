@@ -0,0 +1,163 @@
+#pragma once
+
+#include "LL1Parser.h"
+
+// Recursive-descent C++ generated from an LL(1) table (LL1 --emit-rd).
+//
+// The output is a header with one member function per nonterminal, each a
+// switch on the lookahead terminal id whose cases come straight from the
+// dense table's row. A production starting with a terminal consumes it
+// without comparing again, and a production ending in its own nonterminal
+// (E' -> + T E') loops instead of recursing, so long lists do not grow the
+// C++ stack. Semantic actions are a template parameter:
+//
+//     struct Actions {
+//         static constexpr bool exitHooks = true;     // false: exit() is never called
+//         void enter(int production);                  // before the right-hand side
+//         void exit(int production);                   // after it
+//         void token(int32_t terminal, size_t position);
+//     };
+//
+// Production numbers are LL1's (from 1, in table order).
+
+// Identifier-safe spelling of a symbol name
+inline string identifierFor(const string &name) {
+    string id;
+    for (unsigned char c : name) id += isalnum(c) ? (char)c : '_';
+    return id;
+}
+
+inline string quoted(const string &s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+inline void emitRecursiveDescent(const Grammar &g, const LL1Table &table, const string &space, ostream &out) {
+    vector<int> number(g.numProductions());
+    for (int i = 0; i < g.numProductions(); i++) number[g.byLhs[i]] = i + 1;
+    auto function = [&](int sym) { return "parse_" + identifierFor(g.names[sym]) + "_" + to_string(sym); };
+
+    out << "// Generated by LL1 --emit-rd; do not edit.\n"
+        << "#pragma once\n\n"
+        << "#include <cstddef>\n"
+        << "#include <cstdint>\n"
+        << "#include <vector>\n\n"
+        << "namespace " << space << " {\n\n"
+        << "// Terminal ids, as in the grammar tools: the parser reads a buffer of these ending in END\n";
+    for (int t = 0; t < g.numTerminals; t++) {
+        if (t == g.epsilon) continue;
+        out << "//   " << t << "\t" << g.names[t] << "\n";
+    }
+    out << "constexpr int32_t END = " << g.endMarker << ";\n\n"
+        << "constexpr const char *symbolNames[] = {";
+    for (int x = 0; x < g.numSymbols(); x++) out << (x ? ", " : "") << quoted(g.names[x]);
+    out << "};\n\n"
+        << "// Productions, by number\n";
+    for (int i = 0; i < g.numProductions(); i++) out << "//   " << i + 1 << ": " << productionString(g, g.byLhs[i]) << "\n";
+    out << "\n"
+        << "struct NoActions {\n"
+        << "    static constexpr bool exitHooks = false;\n"
+        << "    void enter(int) {}\n"
+        << "    void exit(int) {}\n"
+        << "    void token(int32_t, size_t) {}\n"
+        << "};\n\n"
+        << "template <class Actions = NoActions>\n"
+        << "class Parser {\n"
+        << "public:\n"
+        << "    explicit Parser(Actions actions = Actions()) : act(actions) {}\n\n"
+        << "    // tokens must end with END; on failure position() is the offending token\n"
+        << "    bool parse(const int32_t *tokens) {\n"
+        << "        tok = tokens;\n"
+        << "        pos = 0;\n"
+        << "        exits.clear();\n"
+        << "        return " << function(g.start) << "() && tok[pos] == END;\n"
+        << "    }\n\n"
+        << "    size_t position() const { return pos; }\n"
+        << "    Actions &actions() { return act; }\n\n"
+        << "private:\n"
+        << "    const int32_t *tok = nullptr;\n"
+        << "    size_t pos = 0;\n"
+        << "    Actions act;\n"
+        << "    std::vector<int> exits;     // pending exit() calls of looping productions\n\n"
+        << "    bool match(int32_t t) {\n"
+        << "        if (tok[pos] != t) return false;\n"
+        << "        act.token(t, pos++);\n"
+        << "        return true;\n"
+        << "    }\n";
+
+    for (int a = 0; a < g.numNonTerminals(); a++) {
+        int x = g.nonTerminal(a);
+        vector<int> prods(g.byLhs.begin() + g.lhsStart[a], g.byLhs.begin() + g.lhsStart[a + 1]);
+        auto loops = [&](int p) { return g.rhsLength(p) > 0 && g.rhs(p)[g.rhsLength(p) - 1] == x; };
+        bool looping = any_of(prods.begin(), prods.end(), loops);
+        string indent = looping ? "            " : "        ";
+
+        out << "\n    // " << g.names[x] << " ->";
+        for (size_t i = 0; i < prods.size(); i++) {
+            int p = prods[i];
+            if (i) out << " |";
+            for (int k = 0; k < g.rhsLength(p); k++) out << " " << g.names[g.rhs(p)[k]];
+            if (g.rhsLength(p) == 0) out << " #";
+        }
+        out << "\n    bool " << function(x) << "() {\n";
+        if (looping) {
+            out << "        size_t base = exits.size();\n"
+                << "        for (;;) {\n";
+        }
+        out << indent << "switch (tok[pos]) {\n";
+
+        for (int p : prods) {
+            vector<int> cases;
+            for (int t = 0; t < g.numTerminals; t++) {
+                if (t != g.epsilon && table.at(x, t) == p) cases.push_back(t);
+            }
+            if (cases.empty()) continue;    // never predicted (conflict lost to an earlier production)
+            for (int t : cases) out << indent << "case " << t << ":  // " << g.names[t] << "\n";
+
+            string body = indent + "    ";
+            out << body << "act.enter(" << number[p] << ");\n";
+            int n = g.rhsLength(p);
+            int last = loops(p) ? n - 1 : n;
+            for (int k = 0; k < last; k++) {
+                int sym = g.rhs(p)[k];
+                if (k == 0 && g.isTerminal(sym)) {
+                    // the case label already checked it
+                    out << body << "act.token(" << sym << ", pos++);\n";
+                } else if (g.isTerminal(sym)) {
+                    out << body << "if (!match(" << sym << ")) return false;  // " << g.names[sym] << "\n";
+                } else {
+                    out << body << "if (!" << function(sym) << "()) return false;\n";
+                }
+            }
+            if (loops(p)) {
+                out << body << "if constexpr (Actions::exitHooks) exits.push_back(" << number[p] << ");\n"
+                    << body << "continue;\n";
+            } else {
+                out << body << "if constexpr (Actions::exitHooks) act.exit(" << number[p] << ");\n";
+                if (looping) out << body << "break;\n";
+                else out << body << "return true;\n";
+            }
+        }
+        out << indent << "default:\n"
+            << indent << "    return false;\n"
+            << indent << "}\n";
+        if (looping) {
+            out << "            break;\n"
+                << "        }\n"
+                << "        if constexpr (Actions::exitHooks) {\n"
+                << "            while (exits.size() > base) {\n"
+                << "                act.exit(exits.back());\n"
+                << "                exits.pop_back();\n"
+                << "            }\n"
+                << "        }\n"
+                << "        return true;\n";
+        }
+        out << "    }\n";
+    }
+    out << "};\n\n"
+        << "}  // namespace " << space << "\n";
+}
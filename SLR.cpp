@@ -3,16 +3,13 @@
 #include <map>
 #include <set>
 #include <string>
+#include <algorithm>
+#include "GrammarFile.h"
+#include "GrammarStats.h"
+#include "LRTable.h"
 
 using namespace std;
 
-// Production rule structure
-struct Production {
-    char lhs;
-    string rhs;
-    Production(char l, string r) : lhs(l), rhs(r) {}
-};
-
 // Item structure for LR(0) items
 struct Item {
     int prodIndex;
@@ -30,106 +27,60 @@ struct Item {
 
 class SLRTableBuilder {
 private:
-    vector<Production> prods;
-    map<pair<int, char>, string> actionTable;
-    map<pair<int, char>, int> gotoTable;
-    
-    // Helper function to check if character is non-terminal
-    bool isNonTerminal(char c) {
-        return c >= 'A' && c <= 'Z';
-    }
+    Grammar g;
+    BitMatrix follow;
+    map<pair<int, int>, string> actionTable;
+    map<pair<int, int>, int> gotoTable;
+    vector<string> conflicts;       // ACTION cells claimed twice (see setAction)
+    PhaseStats *stats = nullptr;    // --stats: time the phases instead of printing
+    int numStates = 0;
     
-    // Helper function to check if character is terminal
-    bool isTerminal(char c) {
-        return !isNonTerminal(c) && c != '$';
+    // Symbol after the dot, or -1 if the dot is at the end
+    int nextSymbol(const Item& item) {
+        if (item.dotPos >= g.rhsLength(item.prodIndex)) return -1;
+        return g.rhs(item.prodIndex)[item.dotPos];
     }
     
     // Get closure of items
     set<Item> getClosure(const set<Item>& items) {
         set<Item> closure = items;
-        bool changed = true;
+        vector<Item> work(items.begin(), items.end());
         
-        while (changed) {
-            changed = false;
-            set<Item> newItems;
+        while (!work.empty()) {
+            Item item = work.back();
+            work.pop_back();
             
-            for (const auto& item : closure) {
-                const Production& prod = prods[item.prodIndex];
-                
-                // If dot is at the end, skip
-                if (item.dotPos >= prod.rhs.length()) continue;
-                
-                char nextSym = prod.rhs[item.dotPos];
-                
-                // If next symbol is non-terminal
-                if (isNonTerminal(nextSym)) {
-                    // Add all productions of this non-terminal
-                    for (int i = 0; i < prods.size(); i++) {
-                        if (prods[i].lhs == nextSym) {
-                            Item newItem(i, 0);
-                            if (closure.find(newItem) == closure.end()) {
-                                newItems.insert(newItem);
-                                changed = true;
-                            }
-                        }
+            int nextSym = nextSymbol(item);
+            
+            // If next symbol is non-terminal
+            if (nextSym >= 0 && !g.isTerminal(nextSym)) {
+                // Add all productions of this non-terminal
+                int r = g.row(nextSym);
+                for (int k = g.lhsStart[r]; k < g.lhsStart[r + 1]; k++) {
+                    Item newItem(g.byLhs[k], 0);
+                    if (closure.insert(newItem).second) {
+                        work.push_back(newItem);
                     }
                 }
             }
-            
-            for (const auto& item : newItems) {
-                closure.insert(item);
-            }
         }
         
         return closure;
     }
     
     // Get goto set
-    set<Item> getGoto(const set<Item>& items, char symbol) {
+    set<Item> getGoto(const set<Item>& items, int symbol) {
         set<Item> gotoSet;
         
         for (const auto& item : items) {
-            const Production& prod = prods[item.prodIndex];
-            
-            if (item.dotPos < prod.rhs.length() && prod.rhs[item.dotPos] == symbol) {
+            if (nextSymbol(item) == symbol) {
                 gotoSet.insert(Item{item.prodIndex, item.dotPos + 1});
             }
         }
         
         return getClosure(gotoSet);
     }
-    
-    // Check if two sets of items are equal
-    bool areItemsEqual(const set<Item>& a, const set<Item>& b) {
-        if (a.size() != b.size()) return false;
-        
-        auto it1 = a.begin();
-        auto it2 = b.begin();
-        
-        while (it1 != a.end() && it2 != b.end()) {
-            if (!(*it1 == *it2)) return false;
-            ++it1;
-            ++it2;
-        }
-        
-        return true;
-    }
-    
-    // Simplified FOLLOW sets for our simple grammar
-    set<char> getFollow(char nonTerm) {
-        set<char> follow;
-        
-        if (nonTerm == 'S') {
-            follow.insert('$');
-        } else if (nonTerm == 'A') {
-            follow.insert('+');
-        } else if (nonTerm == 'B') {
-            follow.insert('$');
-        }
-        
-        return follow;
-    }
-    
+
 public:
     SLRTableBuilder() {
         // VERY SIMPLE GRAMMAR:
@@ -137,95 +88,111 @@ public:
         // A -> a
         // B -> b
         
-        prods.push_back(Production('X', "S"));  // Augmented production (0)
-        prods.push_back(Production('S', "A+B")); // Production 1
-        prods.push_back(Production('A', "a"));   // Production 2
-        prods.push_back(Production('B', "b"));   // Production 3
+        GrammarBuilder grammar;
+        grammar.addProduction("S'", {"S"});  // Augmented production (0)
+        grammar.addLine("S->A+B");           // Production 1
+        grammar.addLine("A->a");             // Production 2
+        grammar.addLine("B->b");             // Production 3
+        g = grammar.build("S'");
+        
+        // FOLLOW(S') = { $ } flows into FOLLOW(S)
+        follow = computeFollow(g, computeFirst(g));
+    }
+    
+    // augmented grammar: production 0 is S' -> S
+    SLRTableBuilder(const Grammar &augmented, PhaseStats *phases = nullptr) : g(augmented), stats(phases) {
+        if (stats) stats->start();
+        follow = computeFollow(g, computeFirst(g));
+        if (stats) stats->stop("first_follow");
     }
     
     void buildTable() {
         // Step 1: Build canonical collection of LR(0) items
         vector<set<Item>> states;
-        map<pair<int, char>, int> transitions;
+        map<set<Item>, int> stateIndex;
+        map<pair<int, int>, int> transitions;
         
-        // Initial state: closure of {[X -> .S]}
+        // Initial state: closure of {[S' -> .S]}
         set<Item> initial;
         initial.insert(Item{0, 0});
         states.push_back(getClosure(initial));
+        stateIndex[states[0]] = 0;
         
         // Build states
         for (int i = 0; i < states.size(); i++) {
             set<Item> currentState = states[i];
             
             // Get all symbols that appear after dots
-            set<char> symbols;
+            set<int> symbols;
             for (const auto& item : currentState) {
-                const Production& prod = prods[item.prodIndex];
-                if (item.dotPos < prod.rhs.length()) {
-                    symbols.insert(prod.rhs[item.dotPos]);
+                if (nextSymbol(item) >= 0) {
+                    symbols.insert(nextSymbol(item));
                 }
             }
             
             // For each symbol, compute goto
-            for (char sym : symbols) {
+            // in name order, so states are numbered as in the original char-based tables
+            vector<int> order(symbols.begin(), symbols.end());
+            sort(order.begin(), order.end(), [&](int a, int b) { return g.names[a] < g.names[b]; });
+            for (int sym : order) {
                 set<Item> gotoSet = getGoto(currentState, sym);
                 
                 if (!gotoSet.empty()) {
-                    // Check if this state already exists
-                    int stateIndex = -1;
-                    for (int j = 0; j < states.size(); j++) {
-                        if (areItemsEqual(states[j], gotoSet)) {
-                            stateIndex = j;
-                            break;
-                        }
-                    }
-                    
-                    if (stateIndex == -1) {
-                        stateIndex = states.size();
+                    // Reuse the state if it already exists
+                    auto found = stateIndex.find(gotoSet);
+                    int target;
+                    if (found == stateIndex.end()) {
+                        target = states.size();
+                        stateIndex[gotoSet] = target;
                         states.push_back(gotoSet);
+                    } else {
+                        target = found->second;
                     }
                     
-                    transitions[{i, sym}] = stateIndex;
+                    transitions[{i, sym}] = target;
                 }
             }
         }
+        if (stats) stats->stop("slr_automaton");
         
         // Step 2: Build ACTION and GOTO tables
+        numStates = states.size();
         for (int i = 0; i < states.size(); i++) {
             set<Item> currentState = states[i];
             
             // Check each item in the state
             for (const auto& item : currentState) {
-                const Production& prod = prods[item.prodIndex];
+                int nextSym = nextSymbol(item);
                 
                 // Case 1: Shift
-                if (item.dotPos < prod.rhs.length()) {
-                    char nextSym = prod.rhs[item.dotPos];
-                    if (isTerminal(nextSym)) {
+                if (nextSym >= 0) {
+                    if (g.isTerminal(nextSym)) {
                         auto it = transitions.find({i, nextSym});
                         if (it != transitions.end()) {
-                            actionTable[{i, nextSym}] = "s" + to_string(it->second);
+                            setAction(g, actionTable, conflicts, i, nextSym, "s" + to_string(it->second));
                         }
                     }
                 }
                 // Case 2: Reduce/Accept
                 else {
                     if (item.prodIndex == 0) {
-                        // X -> S.
-                        actionTable[{i, '$'}] = "acc";
+                        // S' -> S.
+                        setAction(g, actionTable, conflicts, i, g.endMarker, "acc");
                     } else {
-                        // Regular reduce
-                        set<char> follow = getFollow(prod.lhs);
-                        for (char terminal : follow) {
-                            actionTable[{i, terminal}] = "r" + to_string(item.prodIndex);
+                        // Regular reduce on FOLLOW(lhs)
+                        int lhs = g.prodLhs[item.prodIndex];
+                        for (int t = 0; t < g.numTerminals; t++) {
+                            if (follow.test(g.row(lhs), t)) {
+                                setAction(g, actionTable, conflicts, i, t, "r" + to_string(item.prodIndex));
+                            }
                         }
                     }
                 }
             }
             
             // Build GOTO table for non-terminals
-            for (char nt = 'A'; nt <= 'Z'; nt++) {
-                if (nt == 'X') continue;  // Skip augmented start
+            for (int nt = g.numTerminals; nt < g.numSymbols(); nt++) {
+                if (nt == g.start) continue;  // Skip augmented start
                 
                 auto it = transitions.find({i, nt});
                 if (it != transitions.end()) {
@@ -234,37 +201,55 @@ public:
             }
         }
         
+        if (stats) {
+            stats->stop("slr_table");
+            countAutomaton(states, transitions.size());
+            return;
+        }
+        
         // Display results
         displayTables(states);
     }
     
+    // The tables as integer arrays, after buildTable()
+    LRTables compiled() const { return compileLR(g, numStates, actionTable, gotoTable); }
+    const vector<string>& actionConflicts() const { return conflicts; }
+    
+    void countAutomaton(const vector<set<Item>>& states, size_t transitions) {
+        size_t items = 0;
+        for (const auto& state : states) items += state.size();
+        stats->count("states", states.size());
+        stats->count("items", items);
+        stats->count("transitions", transitions);
+        stats->count("actions", actionTable.size());
+        stats->count("conflicts", conflicts.size());
+    }
+    
     void displayTables(const vector<set<Item>>& states) {
         // cout << "SLR PARSING TABLE FOR SIMPLE GRAMMAR\n";
         // cout << "====================================\n\n";
         
         cout << "Grammar:\n";
-        cout << "0: S' -> S     (augmented start)\n";
-        cout << "1: S -> A + B\n";
-        cout << "2: A -> a\n";
-        cout << "3: B -> b\n\n";
-        
-        // Create list of terminals and non-terminals
-        set<char> terminals = {'a', 'b', '+', '$'};
-        set<char> nonTerminals = {'S', 'A', 'B'};
+        for (int p = 0; p < g.numProductions(); p++) {
+            cout << p << ": " << productionString(g, p);
+            if (p == 0) cout << "     (augmented start)";
+            cout << "\n";
+        }
+        cout << "\n";
         
         // Display combined ACTION and GOTO table in one row per state
         cout << "SLR(1) Parsing Table\n";
         cout << "State\t";
         
         // First display ACTION columns (terminals)
-        for (char t : terminals) {
-            cout << t << "\t";
+        for (int t = 0; t < g.numTerminals; t++) {
+            if (t != g.epsilon) cout << g.names[t] << "\t";
         }
         
         // Then display GOTO columns (non-terminals)
-        for (char nt : nonTerminals) {
-            if (nt != 'X') {  // Skip augmented start
-                cout << nt << "\t";
+        for (int nt = g.numTerminals; nt < g.numSymbols(); nt++) {
+            if (nt != g.start) {  // Skip augmented start
+                cout << g.names[nt] << "\t";
             }
         }
         cout << endl;
@@ -274,7 +259,8 @@ public:
             cout << i << "\t";
             
             // Display ACTION table entries
-            for (char t : terminals) {
+            for (int t = 0; t < g.numTerminals; t++) {
+                if (t == g.epsilon) continue;
                 auto it = actionTable.find({i, t});
                 if (it != actionTable.end()) {
                     cout << it->second;
@@ -283,8 +269,8 @@ public:
             }
             
             // Display GOTO table entries
-            for (char nt : nonTerminals) {
-                if (nt != 'X') {  // Skip augmented start
+            for (int nt = g.numTerminals; nt < g.numSymbols(); nt++) {
+                if (nt != g.start) {  // Skip augmented start
                     auto it = gotoTable.find({i, nt});
                     if (it != gotoTable.end()) {
                         cout << it->second;
@@ -294,6 +280,10 @@ public:
             }
             cout << endl;
         }
+        if (!conflicts.empty()) {
+            cout << "\nWARNING: ";
+            printLRConflicts(cout, "SLR(1)", conflicts);
+        }
         
         // Display legend
         // cout << "\nLEGEND:\n";
@@ -308,27 +298,54 @@ public:
         for (int i = 0; i < states.size(); i++) {
             cout << "\nI" << i << ":\n";
             for (const auto& item : states[i]) {
-                const Production& prod = prods[item.prodIndex];
-                cout << "  " << prod.lhs << " -> ";
-                for (int j = 0; j < prod.rhs.length(); j++) {
-                    if (j == item.dotPos) cout << ".";
-                    cout << prod.rhs[j];
-                }
-                if (item.dotPos == prod.rhs.length()) cout << ".";
+                cout << "  " << itemString(g, item.prodIndex, item.dotPos);
                 // cout << endl;
             }
         }
-        
-        // Display productions separately
-        // cout << "\nProductions:\n";
-        // for (int i = 0; i < prods.size(); i++) {
-        //     cout << i << ": " << prods[i].lhs << " -> " << prods[i].rhs << endl;
-        // }
     }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
+    // --grammar file builds the table for a grammar file instead of the example (see GrammarFile.h)
+    // --stats prints phase timings instead of the table (see GrammarStats.h)
+    // --compress reports comb-vector table sizes instead, and with --bench N the parse
+    //   rates on a generated sentence of about N tokens (see LRTable.h); both need a
+    //   table without conflicts
+    const char *grammarFile = nullptr;
+    bool stats = false;
+    bool compress = false;
+    size_t benchTokens = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--grammar" && i + 1 < argc) grammarFile = argv[++i];
+        else if (arg == "--stats") stats = true;
+        else if (arg == "--compress") compress = true;
+        else if (arg == "--bench" && i + 1 < argc) benchTokens = atoll(argv[++i]);
+    }
+    
+    if (grammarFile) {
+        Grammar g;
+        string error;
+        if (!loadGrammarFile(grammarFile, g, error, true)) {
+            cerr << error << "\n";
+            return 1;
+        }
+        PhaseStats phases;
+        if (stats) countGrammar(phases, g);
+        // compressing builds the table through the quiet --stats path
+        SLRTableBuilder parser(g, stats || compress ? &phases : nullptr);
+        parser.buildTable();
+        if (compress && !parser.actionConflicts().empty()) {
+            printLRConflicts(cerr, "SLR(1)", parser.actionConflicts());
+            cerr << "--compress and --bench need a conflict-free table\n";
+            return 1;
+        }
+        if (compress && !reportLRCompression(g, parser.compiled(), benchTokens, stats ? &phases : nullptr)) return 1;
+        if (stats) phases.print();
+        return 0;
+    }
+
     SLRTableBuilder parser;
     parser.buildTable();
     return 0;
-}
\ No newline at end of file
+}